@@ -0,0 +1,585 @@
+// Simulation microbenchmarks: Game::update, resolveCollisions on its own,
+// addPlayer/removePlayer churn and game state serialize/deserialize, with
+// synthetic players laid out uniformly, in tight clusters, or rushing the
+// enemy flag, at 8 to 10000 players on the built-in 800x600 arena (so the
+// large sizes are very crowded, the worst case for collision islands).
+//
+// Each case restores the same layout before every sample, so runs on the
+// same machine are comparable and can be checked against a baseline.
+//
+// usage: tagpro_bench [--sizes 8,100,1000,10000] [--filter TEXT] [--min-time-ms 300]
+//                     [--out results.json] [--baseline baseline.json] [--threshold 10]
+//        tagpro_bench --compare baseline.json results.json [--threshold 10]
+//        tagpro_bench --check-allocations [--sizes ...]
+// Results are JSON, on stdout unless --out is given; progress goes to
+// stderr. Comparing exits with 1 if any case got slower than the threshold
+// (percent, on the median). --check-allocations counts heap allocations
+// made by Game::update and the snapshot serialize, then by a server
+// lobby's whole tick (update, broadcast and sends to local clients), and
+// exits with 1 if a tick without events made any once warmed up.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "game/game.h"
+#include "network/logger.h"
+#include "network/protocol.h"
+#include "network/server.h"
+
+// Every heap allocation in the process goes through these; they are
+// counted only on the thread that sets allocationCounting, so the logger's
+// flush thread does not show up. The bench game has no worker pool, so
+// the whole tick runs on that thread.
+static thread_local bool allocationCounting = false;
+static thread_local uint64_t allocationCount = 0;
+
+void* operator new(size_t bytes) {
+    if (allocationCounting) ++allocationCount;
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    if (allocationCounting) ++allocationCount;
+    size_t align = static_cast<size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (bytes + align - 1) / align * align)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// the parts of RulesGame the collision case drives directly
+struct GameBenchAccess {
+    template <typename Rules>
+    static GameState& state(RulesGame<Rules>& game) { return game.currentState; }
+
+    template <typename Rules>
+    static void resolveCollisions(RulesGame<Rules>& game, float deltaTimeSec) {
+        game.resolveCollisions(deltaTimeSec);
+    }
+
+    // puts back the players and flags of `saved` and drops what the last
+    // sample scheduled or recorded; the tick counter keeps running
+    template <typename Rules>
+    static void restore(RulesGame<Rules>& game, const GameState& saved) {
+        game.currentState.players = saved.players;
+        game.currentState.redFlag = saved.redFlag;
+        game.currentState.blueFlag = saved.blueFlag;
+        game.currentState.redScore = saved.redScore;
+        game.currentState.blueScore = saved.blueScore;
+        game.timers.clear();
+        game.respawnTimers.clear();
+        game.tickEvents.clear();
+    }
+};
+
+// the parts of Server the broadcast case drives directly: the lobby the
+// local clients joined is started without a tick job, so the bench thread
+// runs its ticks and can count them
+struct ServerBenchAccess {
+    // the server's end of the client that joined last
+    static std::shared_ptr<Connection> newestClient(Server& server) {
+        std::lock_guard<std::mutex> lock(server.clientsMutex);
+        return server.clientThreads.back()->connection;
+    }
+
+    static Lobby* startFirstLobby(Server& server) {
+        std::lock_guard<std::mutex> lock(server.clientsMutex);
+        Lobby* lobby = server.findLobby(1);
+        if (!lobby) return nullptr;
+        lobby->gameRunning = true;
+        lobby->game->start();
+        return lobby;
+    }
+
+    static void tick(Server& server, Lobby* lobby, uint32_t elapsedMs) { server.tickLobby(lobby, elapsedMs); }
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using BenchGame = RulesGame<ClassicRules>;
+
+constexpr uint32_t stepMs = 16;
+constexpr size_t minSamples = 5;
+constexpr size_t maxSamples = 2000;
+constexpr int churnPerSample = 64; // remove/add pairs timed together
+
+enum Distribution { UNIFORM, CLUSTERED, FLAG_RUSH };
+constexpr const char* distributionNames[] = {"uniform", "clustered", "flag-rush"};
+
+struct Options {
+    std::vector<int> sizes = {8, 100, 1000, 10000};
+    std::string filter;
+    std::chrono::milliseconds minTime{300};
+    std::string outPath;
+    std::string baselinePath;
+    double thresholdPercent = 10;
+};
+
+struct Result {
+    std::string name;
+    int players = 0;
+    size_t iterations = 0;
+    double medianNs = 0, minNs = 0, meanNs = 0;
+};
+
+// A game with `count` players laid out by `distribution`, each holding an
+// input that keeps the layout's shape: a random heading (uniform), into
+// its cluster, or at the enemy flag.
+struct Scenario {
+    std::unique_ptr<BenchGame> game;
+    GameState saved;
+    std::vector<std::pair<float, float>> inputs; // by player id - 1
+};
+
+float clampTo(float v, float low, float high) { return std::min(std::max(v, low), high); }
+
+Scenario makeScenario(Distribution distribution, int count, uint32_t seed) {
+    Scenario scenario;
+    scenario.game = std::make_unique<BenchGame>(1, 0, MODE_CLASSIC);
+    BenchGame& game = *scenario.game;
+    for (int p = 0; p < count; ++p) game.addPlayer("Bot" + std::to_string(p + 1), p % 2);
+    game.start();
+
+    std::mt19937 rng(seed);
+    const Map& map = game.getMap();
+    const float r = Game::playerRadius;
+    std::uniform_real_distribution<float> across(r, map.getWidth() - r), down(r, map.getHeight() - r);
+    std::uniform_real_distribution<float> angle(0, 2 * 3.14159265f);
+    std::vector<std::pair<float, float>> centers;
+    if (distribution == CLUSTERED) {
+        for (int c = 0; c < std::max(1, count / 16); ++c) centers.push_back({across(rng), down(rng)});
+    }
+
+    GameState& state = GameBenchAccess::state(game);
+    scenario.inputs.resize(count);
+    for (auto& [id, player] : state.players) {
+        float x, y, inputX, inputY;
+        if (distribution == UNIFORM) {
+            x = across(rng);
+            y = down(rng);
+            float a = angle(rng);
+            inputX = std::cos(a);
+            inputY = std::sin(a);
+        } else {
+            float centerX, centerY, spread;
+            if (distribution == CLUSTERED) {
+                std::tie(centerX, centerY) = centers[rng() % centers.size()];
+                spread = 2.5f * r;
+            } else {
+                uint8_t enemy = player.team == REDTEAM ? BLUETEAM : REDTEAM;
+                centerX = map.getFlagX(enemy);
+                centerY = map.getFlagY(enemy);
+                spread = 4 * r;
+            }
+            std::normal_distribution<float> offset(0, spread);
+            x = clampTo(centerX + offset(rng), r, map.getWidth() - r);
+            y = clampTo(centerY + offset(rng), r, map.getHeight() - r);
+            float dx = centerX - x, dy = centerY - y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            inputX = length > 1 ? dx / length : 0;
+            inputY = length > 1 ? dy / length : 0;
+        }
+        // already moving along the input, so swept tests see real paths
+        player.velocityX = inputX * 200;
+        player.velocityY = inputY * 200;
+        player.x = x;
+        player.y = y;
+        player.prevX = x - player.velocityX * stepMs / 1000.0f;
+        player.prevY = y - player.velocityY * stepMs / 1000.0f;
+        player.contactX = player.prevX;
+        player.contactY = player.prevY;
+        player.inputX = inputX;
+        player.inputY = inputY;
+        scenario.inputs[id - 1] = {inputX, inputY};
+    }
+    scenario.saved = state;
+    return scenario;
+}
+
+// sample() returns the nanoseconds of one timed operation; setup it does
+// before starting its clock is not counted
+Result measure(const std::string& name, int players, const Options& options,
+               const std::function<double()>& sample) {
+    sample(); // warm-up
+    std::vector<double> samples;
+    auto begin = Clock::now();
+    while (samples.size() < minSamples ||
+           (Clock::now() - begin < options.minTime && samples.size() < maxSamples)) {
+        samples.push_back(sample());
+    }
+    std::sort(samples.begin(), samples.end());
+    Result result;
+    result.name = name;
+    result.players = players;
+    result.iterations = samples.size();
+    result.medianNs = samples[samples.size() / 2];
+    result.minNs = samples.front();
+    for (double ns : samples) result.meanNs += ns;
+    result.meanNs /= samples.size();
+    fprintf(stderr, "%-32s %10zu %14.0f %14.0f\n", name.c_str(), result.iterations, result.medianNs, result.minNs);
+    return result;
+}
+
+double elapsedNs(Clock::time_point begin) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+}
+
+std::vector<Result> runSuite(const Options& options) {
+    std::vector<Result> results;
+    auto wanted = [&](const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+    fprintf(stderr, "%-32s %10s %14s %14s\n", "case", "samples", "median ns", "min ns");
+
+    for (int size : options.sizes) {
+        for (Distribution distribution : {UNIFORM, CLUSTERED, FLAG_RUSH}) {
+            std::string suffix = std::string(distributionNames[distribution]) + "/" + std::to_string(size);
+            std::string updateName = "update/" + suffix, collisionsName = "collisions/" + suffix;
+            if (!wanted(updateName) && !wanted(collisionsName)) continue;
+            Scenario scenario = makeScenario(distribution, size, static_cast<uint32_t>(size * 3 + distribution));
+            BenchGame& game = *scenario.game;
+
+            if (wanted(updateName)) {
+                results.push_back(measure(updateName, size, options, [&] {
+                    GameBenchAccess::restore(game, scenario.saved);
+                    for (size_t i = 0; i < scenario.inputs.size(); ++i) {
+                        game.queuePlayerInput(static_cast<uint32_t>(i + 1), scenario.inputs[i].first,
+                                              scenario.inputs[i].second);
+                    }
+                    auto begin = Clock::now();
+                    game.update(stepMs);
+                    return elapsedNs(begin);
+                }));
+            }
+            if (wanted(collisionsName)) {
+                results.push_back(measure(collisionsName, size, options, [&] {
+                    GameBenchAccess::restore(game, scenario.saved);
+                    auto begin = Clock::now();
+                    GameBenchAccess::resolveCollisions(game, stepMs / 1000.0f);
+                    return elapsedNs(begin);
+                }));
+            }
+        }
+
+        std::string churnName = "churn/" + std::to_string(size);
+        if (wanted(churnName)) {
+            // the lowest free id is reused, so every sample starts from a full game
+            Scenario scenario = makeScenario(UNIFORM, size, static_cast<uint32_t>(size));
+            std::mt19937 rng(static_cast<uint32_t>(size));
+            std::uniform_int_distribution<uint32_t> pick(1, static_cast<uint32_t>(size));
+            results.push_back(measure(churnName, size, options, [&] {
+                auto begin = Clock::now();
+                for (int i = 0; i < churnPerSample; ++i) {
+                    uint32_t id = pick(rng);
+                    scenario.game->removePlayer(id);
+                    scenario.game->addPlayer("Bot" + std::to_string(id), id % 2);
+                }
+                return elapsedNs(begin) / churnPerSample;
+            }));
+        }
+
+        std::string serializeName = "serialize/" + std::to_string(size);
+        std::string deserializeName = "deserialize/" + std::to_string(size);
+        if (wanted(serializeName) || wanted(deserializeName)) {
+            Scenario scenario = makeScenario(UNIFORM, size, static_cast<uint32_t>(size));
+            const GameState& state = scenario.saved;
+            std::string message = Protocol::serializeGameState(state);
+            if (wanted(serializeName)) {
+                results.push_back(measure(serializeName, size, options, [&] {
+                    auto begin = Clock::now();
+                    std::string serialized = Protocol::serializeGameState(state);
+                    double ns = elapsedNs(begin);
+                    if (serialized.size() != message.size()) fprintf(stderr, "serialize is not deterministic\n");
+                    return ns;
+                }));
+            }
+            if (wanted(deserializeName)) {
+                results.push_back(measure(deserializeName, size, options, [&] {
+                    GameState decoded;
+                    auto begin = Clock::now();
+                    bool ok = Protocol::deserializeGameState(message, decoded);
+                    double ns = elapsedNs(begin);
+                    if (!ok || decoded.players.size() != state.players.size()) {
+                        fprintf(stderr, "deserialize lost players\n");
+                    }
+                    return ns;
+                }));
+            }
+        }
+    }
+    return results;
+}
+
+std::string toJson(const std::vector<Result>& results) {
+    std::string out = "{\"bench\":\"tagpro_bench\",\"unit\":\"ns\",\"results\":[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "  {\"name\":\"%s\",\"players\":%d,\"iterations\":%zu,\"medianNs\":%.1f,\"minNs\":%.1f,\"meanNs\":%.1f}%s\n",
+                 r.name.c_str(), r.players, r.iterations, r.medianNs, r.minNs, r.meanNs,
+                 i + 1 < results.size() ? "," : "");
+        out += line;
+    }
+    out += "]}\n";
+    return out;
+}
+
+// reads the medians back from a file toJson wrote: one result per line
+bool readResults(const std::string& path, std::map<std::string, double>& medians) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name = line.find("\"name\":\"");
+        size_t median = line.find("\"medianNs\":");
+        if (name == std::string::npos || median == std::string::npos) continue;
+        name += 8;
+        medians[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + median + 11);
+    }
+    return true;
+}
+
+// prints every case of either file; true if none got slower by more than the threshold
+bool compare(const std::map<std::string, double>& baseline, const std::map<std::string, double>& current,
+             double thresholdPercent, FILE* out) {
+    fprintf(out, "%-32s %14s %14s %9s\n", "case", "baseline ns", "current ns", "change");
+    int regressions = 0;
+    for (const auto& [name, now] : current) {
+        auto before = baseline.find(name);
+        if (before == baseline.end()) {
+            fprintf(out, "%-32s %14s %14.0f %9s  new\n", name.c_str(), "-", now, "");
+            continue;
+        }
+        double change = before->second > 0 ? (now - before->second) / before->second * 100 : 0;
+        const char* verdict = "";
+        if (change > thresholdPercent) {
+            verdict = "  REGRESSION";
+            ++regressions;
+        } else if (change < -thresholdPercent) {
+            verdict = "  faster";
+        }
+        fprintf(out, "%-32s %14.0f %14.0f %+8.1f%%%s\n", name.c_str(), before->second, now, change, verdict);
+    }
+    size_t missing = 0;
+    for (const auto& [name, before] : baseline) missing += current.count(name) == 0;
+    if (missing) fprintf(out, "%zu baseline case%s not in this run\n", missing, missing == 1 ? "" : "s");
+    fprintf(out, "%d regression%s over %.0f%%\n", regressions, regressions == 1 ? "" : "s", thresholdPercent);
+    return regressions == 0;
+}
+
+// A full lobby of local clients on a real server, ticked through
+// Server::tickLobby: update, the shared snapshot, the recipient list and
+// a send to every member. Between ticks the clients take what was sent to
+// them, outside the count, so the snapshot buffer is free to be reused as
+// it is when clients keep up.
+bool checkBroadcastAllocations(const Options& options, int warmupTicks, int countedTicks) {
+    std::string name = "allocations/broadcast/" + std::to_string(Server::maxPlayersPerLobby);
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return true;
+    Server server(0); // any free port; nothing connects over TCP
+    if (!server.init()) {
+        fprintf(stderr, "%-32s could not start a server\n", name.c_str());
+        return false;
+    }
+    server.start(true);
+    std::vector<std::pair<std::shared_ptr<Connection>, std::shared_ptr<Connection>>> clients; // server end, client end
+    for (size_t i = 0; i < Server::maxPlayersPerLobby; ++i) {
+        std::shared_ptr<Connection> clientEnd = server.connectLocal();
+        clients.emplace_back(ServerBenchAccess::newestClient(server), clientEnd);
+    }
+    Lobby* lobby = ServerBenchAccess::startFirstLobby(server);
+    if (!lobby) {
+        fprintf(stderr, "%-32s local clients did not get a lobby\n", name.c_str());
+        return false;
+    }
+
+    std::mt19937 rng(static_cast<uint32_t>(clients.size()));
+    int quietTicks = 0, allocatingQuietTicks = 0, eventTicks = 0;
+    uint64_t eventAllocations = 0;
+    for (int tick = 0; tick < warmupTicks + countedTicks; ++tick) {
+        for (auto& [serverEnd, clientEnd] : clients) {
+            while (serverEnd->pendingSends() > 0) clientEnd->receive();
+        }
+        uint32_t playerId = static_cast<uint32_t>(rng() % clients.size() + 1);
+        float angle = static_cast<float>(rng() % 360) * 3.14159265f / 180.0f;
+        lobby->game->queuePlayerInput(playerId, std::cos(angle), std::sin(angle));
+        allocationCount = 0;
+        allocationCounting = tick >= warmupTicks;
+        ServerBenchAccess::tick(server, lobby, stepMs);
+        allocationCounting = false;
+        if (tick < warmupTicks) continue;
+        if (lobby->game->getTickEvents().empty()) {
+            ++quietTicks;
+            allocatingQuietTicks += allocationCount > 0;
+        } else {
+            ++eventTicks;
+            eventAllocations += allocationCount;
+        }
+    }
+    fprintf(stderr, "%-32s %12d %12d %12d %12llu\n", name.c_str(), quietTicks, allocatingQuietTicks, eventTicks,
+            (unsigned long long)eventAllocations);
+    server.stop();
+    return allocatingQuietTicks == 0;
+}
+
+// Plays each layout forward for warmupTicks, then counts the allocations
+// of every tick's update and serialize over countedTicks. Inputs are
+// queued between ticks, outside the count, as the connection threads do.
+// Ticks with events (grabs, pops, captures) may allocate for the event
+// list and the timers they start, so they are reported separately.
+bool checkAllocations(const Options& options) {
+    constexpr int warmupTicks = 300, countedTicks = 600;
+    bool clean = true;
+    fprintf(stderr, "%-32s %12s %12s %12s %12s\n", "case", "quiet ticks", "allocating", "event ticks",
+            "allocations");
+    for (int size : options.sizes) {
+        for (Distribution distribution : {UNIFORM, CLUSTERED, FLAG_RUSH}) {
+            std::string name = std::string("allocations/") + distributionNames[distribution] + "/" + std::to_string(size);
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos) continue;
+            Scenario scenario = makeScenario(distribution, size, static_cast<uint32_t>(size * 3 + distribution));
+            BenchGame& game = *scenario.game;
+            std::mt19937 rng(static_cast<uint32_t>(size));
+            std::string snapshot;
+            int quietTicks = 0, allocatingQuietTicks = 0, eventTicks = 0;
+            uint64_t eventAllocations = 0;
+            for (int tick = 0; tick < warmupTicks + countedTicks; ++tick) {
+                // a few players change direction each tick, as real clients do
+                for (int i = 0; i < 4; ++i) {
+                    size_t index = rng() % scenario.inputs.size();
+                    auto& [inputX, inputY] = scenario.inputs[index];
+                    game.queuePlayerInput(static_cast<uint32_t>(index + 1), -inputY, inputX);
+                    std::tie(inputX, inputY) = std::make_pair(-inputY, inputX);
+                }
+                allocationCount = 0;
+                allocationCounting = tick >= warmupTicks;
+                game.update(stepMs);
+                game.readState([&](const GameState& state) { Protocol::serializeGameState(state, snapshot); });
+                allocationCounting = false;
+                if (tick < warmupTicks) continue;
+                if (game.getTickEvents().empty()) {
+                    ++quietTicks;
+                    allocatingQuietTicks += allocationCount > 0;
+                } else {
+                    ++eventTicks;
+                    eventAllocations += allocationCount;
+                }
+            }
+            fprintf(stderr, "%-32s %12d %12d %12d %12llu\n", name.c_str(), quietTicks, allocatingQuietTicks,
+                    eventTicks, (unsigned long long)eventAllocations);
+            clean = clean && allocatingQuietTicks == 0;
+        }
+    }
+    clean = checkBroadcastAllocations(options, warmupTicks, countedTicks) && clean;
+    fprintf(stderr, clean ? "no allocations on quiet ticks\n" : "quiet ticks allocated\n");
+    return clean;
+}
+
+std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (int value = std::atoi(item.c_str()); value > 0) values.push_back(value);
+    }
+    return values;
+}
+
+int usage() {
+    fprintf(stderr,
+            "usage: tagpro_bench [--sizes 8,100,1000,10000] [--filter TEXT] [--min-time-ms 300]\n"
+            "                    [--out results.json] [--baseline baseline.json] [--threshold 10]\n"
+            "       tagpro_bench --compare baseline.json results.json [--threshold 10]\n"
+            "       tagpro_bench --check-allocations [--sizes 8,100,1000,10000] [--filter TEXT]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::string> compareFiles;
+    bool allocations = false;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--sizes") == 0 && hasValue) {
+            options.sizes = parseList(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time-ms") == 0 && hasValue) {
+            options.minTime = std::chrono::milliseconds(std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            options.outPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            options.thresholdPercent = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc) {
+            compareFiles = {argv[i + 1], argv[i + 2]};
+            i += 2;
+        } else if (strcmp(argv[i], "--check-allocations") == 0) {
+            allocations = true;
+        } else {
+            return usage();
+        }
+    }
+
+    if (!compareFiles.empty()) {
+        std::map<std::string, double> baseline, current;
+        if (!readResults(compareFiles[0], baseline) || !readResults(compareFiles[1], current)) return 2;
+        return compare(baseline, current, options.thresholdPercent, stdout) ? 0 : 1;
+    }
+    if (options.sizes.empty()) return usage();
+
+    // add/remove log every call; the cost of queueing those lines is part
+    // of the churn case, writing them out is not
+#ifdef _WIN32
+    FILE* discard = fopen("NUL", "w");
+#else
+    FILE* discard = fopen("/dev/null", "w");
+#endif
+    if (discard) Logger::instance().setOutput(discard);
+    if (allocations) return checkAllocations(options) ? 0 : 1;
+
+    std::vector<Result> results = runSuite(options);
+    std::string json = toJson(results);
+    if (options.outPath.empty()) {
+        fputs(json.c_str(), stdout);
+    } else {
+        std::ofstream out(options.outPath);
+        out << json;
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", options.outPath.c_str());
+            return 2;
+        }
+    }
+
+    if (!options.baselinePath.empty()) {
+        std::map<std::string, double> baseline, current;
+        if (!readResults(options.baselinePath, baseline)) return 2;
+        for (const Result& result : results) current[result.name] = result.medianNs;
+        // stdout may be carrying the results
+        return compare(baseline, current, options.thresholdPercent, options.outPath.empty() ? stderr : stdout) ? 0 : 1;
+    }
+    return 0;
+}
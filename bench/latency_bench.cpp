@@ -0,0 +1,203 @@
+// Input-to-snapshot latency over loopback: a Server and N Clients in one
+// process, talking TCP through 127.0.0.1. Every client sends a probe (a
+// change of direction) at random intervals and notes its sequence number
+// and send time; the first snapshot whose lastInputSeq for that player
+// reaches the sequence closes the probe. The path covered is
+// Client::sendPlayerInput, the server's client thread and
+// processClientMessage, the input jitter buffer, Game::update,
+// broadcastGameState and the client's receive thread.
+//
+// usage: tagpro_latency_bench [seconds per run] [tick rates] [client counts...]
+//   tick rates is a comma-separated list, e.g. 30,60,128
+// Each run prints one JSON object per line on stdout and a table row on
+// stderr; server and client logging is discarded.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "network/client.h"
+#include "network/protocol.h"
+#include "network/server.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr unsigned int basePort = 23800;
+constexpr int warmupMs = 1000;     // lets the jitter buffers settle before measuring
+constexpr int drainMs = 500;       // after the last probe; probes still open then are lost
+constexpr int minProbeGapMs = 30;  // probes are spaced randomly so they do not lock to the tick
+constexpr int maxProbeGapMs = 70;
+
+struct Probe {
+    uint32_t sequence;
+    Clock::time_point sent;
+};
+
+struct ProbeClient {
+    Client client;
+    std::mutex mutex;
+    std::deque<Probe> pending; // oldest first
+    std::vector<uint32_t> latenciesUs;
+    uint32_t lastSequence = 0; // inputs this client has sent; Client numbers them from 1
+    float direction = 1;
+    Clock::time_point nextProbe;
+
+    void onMessage(const std::string& message) {
+        if (message.empty() || static_cast<uint8_t>(message[0]) != Protocol::GAME_STATE) return;
+        auto now = Clock::now();
+        GameState state;
+        if (!Protocol::deserializeGameState(message, state)) return;
+        PlayerState* self = state.getPlayer(client.getPlayerId());
+        if (!self) return;
+        // acks are cumulative: an applied input implies every earlier one was handled
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!pending.empty() && pending.front().sequence <= self->lastInputSeq) {
+            latenciesUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - pending.front().sent).count()));
+            pending.pop_front();
+        }
+    }
+};
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+}
+
+void sendProbes(std::vector<std::unique_ptr<ProbeClient>>& clients, std::mt19937& rng, Clock::time_point until) {
+    std::uniform_int_distribution<int> gapMs(minProbeGapMs, maxProbeGapMs);
+    while (Clock::now() < until) {
+        auto now = Clock::now();
+        auto next = until;
+        for (auto& probe : clients) {
+            if (now >= probe->nextProbe) {
+                probe->direction = -probe->direction;
+                {
+                    // queued before sending so the ack cannot beat it
+                    std::lock_guard<std::mutex> lock(probe->mutex);
+                    probe->pending.push_back({++probe->lastSequence, Clock::now()});
+                }
+                probe->client.sendPlayerInput(probe->direction, 0);
+                probe->nextProbe = now + std::chrono::milliseconds(gapMs(rng));
+            }
+            next = std::min(next, probe->nextProbe);
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void runBench(unsigned int port, int clientCount, int tickRate, int seconds) {
+    Server server(port, 0, MODE_CLASSIC, tickRate);
+    if (!server.init()) {
+        fprintf(stderr, "could not listen on port %u\n", port);
+        return;
+    }
+    server.start(true);
+
+    std::vector<std::unique_ptr<ProbeClient>> clients;
+    for (int i = 0; i < clientCount; ++i) {
+        auto probe = std::make_unique<ProbeClient>();
+        ProbeClient* raw = probe.get();
+        probe->client.setMessageCallback([raw](const std::string& message) { raw->onMessage(message); });
+        probe->client.connect(static_cast<int>(port), "127.0.0.1");
+        clients.push_back(std::move(probe));
+    }
+    auto joinDeadline = Clock::now() + std::chrono::seconds(5);
+    for (auto& probe : clients) {
+        while ((probe->client.getPlayerId() == 0 || probe->client.getLobbyId() == 0) && Clock::now() < joinDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::set<uint32_t> lobbyIds;
+    for (auto& probe : clients) lobbyIds.insert(probe->client.getLobbyId());
+    for (uint32_t lobbyId : lobbyIds) server.start_game(lobbyId);
+
+    std::mt19937 rng(static_cast<uint32_t>(clientCount * 1000 + tickRate));
+    auto start = Clock::now();
+    for (auto& probe : clients) probe->nextProbe = start;
+    sendProbes(clients, rng, start + std::chrono::milliseconds(warmupMs));
+    for (auto& probe : clients) {
+        std::lock_guard<std::mutex> lock(probe->mutex);
+        probe->latenciesUs.clear();
+        probe->pending.clear(); // acked later, they would count as measured
+    }
+    sendProbes(clients, rng, Clock::now() + std::chrono::seconds(seconds));
+    std::this_thread::sleep_for(std::chrono::milliseconds(drainMs));
+
+    std::vector<uint32_t> latencies;
+    uint64_t lost = 0;
+    for (auto& probe : clients) {
+        std::lock_guard<std::mutex> lock(probe->mutex);
+        latencies.insert(latencies.end(), probe->latenciesUs.begin(), probe->latenciesUs.end());
+        lost += probe->pending.size();
+    }
+    for (auto& probe : clients) probe->client.disconnect();
+    server.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0;
+    for (uint32_t latency : latencies) mean += latency;
+    if (!latencies.empty()) mean /= latencies.size();
+
+    printf("{\"bench\":\"input_to_snapshot\",\"clients\":%d,\"tickRate\":%d,\"seconds\":%d,"
+           "\"probes\":%zu,\"lost\":%llu,\"meanUs\":%.0f,\"p50Us\":%u,\"p99Us\":%u,\"p999Us\":%u,\"maxUs\":%u}\n",
+           clientCount, tickRate, seconds, latencies.size(), (unsigned long long)lost, mean,
+           percentile(latencies, 0.50), percentile(latencies, 0.99), percentile(latencies, 0.999),
+           latencies.empty() ? 0 : latencies.back());
+    fflush(stdout);
+    fprintf(stderr, "%7d %5d %8zu %6llu %8.2f %8.2f %8.2f %8.2f\n", clientCount, tickRate, latencies.size(),
+            (unsigned long long)lost, percentile(latencies, 0.50) / 1000.0, percentile(latencies, 0.99) / 1000.0,
+            percentile(latencies, 0.999) / 1000.0, latencies.empty() ? 0.0 : latencies.back() / 1000.0);
+}
+
+std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (int value = std::atoi(item.c_str()); value > 0) values.push_back(value);
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    std::vector<int> tickRates = parseList(argc > 2 ? argv[2] : "60");
+    std::vector<int> clientCounts;
+    for (int i = 3; i < argc; ++i) clientCounts.push_back(std::atoi(argv[i]));
+    if (clientCounts.empty()) clientCounts = {1, 8, 32};
+    if (tickRates.empty() || seconds < 1) {
+        fprintf(stderr, "usage: tagpro_latency_bench [seconds] [tick rates, e.g. 30,60,128] [client counts...]\n");
+        return 1;
+    }
+
+#ifdef _WIN32
+    FILE* discard = fopen("NUL", "w");
+#else
+    FILE* discard = fopen("/dev/null", "w");
+#endif
+    if (discard) Logger::instance().setOutput(discard);
+
+    fprintf(stderr, "input-to-snapshot latency over loopback, %d s per run; times in ms\n", seconds);
+    fprintf(stderr, "%7s %5s %8s %6s %8s %8s %8s %8s\n", "clients", "Hz", "probes", "lost", "p50", "p99", "p99.9", "max");
+    unsigned int port = basePort;
+    for (int tickRate : tickRates) {
+        for (int clientCount : clientCounts) {
+            runBench(port++, clientCount, tickRate, seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Cost of a log call on the calling thread under contention: T threads
+// log as fast as they can, through LOG and through the old scheme
+// (a global mutex, formatting on the caller, then the write). Output goes
+// to /dev/null and the per-site rate limit is off, so every call does the
+// full work.
+//
+// usage: tagpro_log_bench [calls per thread] [thread counts...]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "network/logger.h"
+
+namespace {
+
+std::mutex legacyMutex;
+FILE* sink = nullptr;
+
+void legacyLog(unsigned playerId, const char* name, double rate) {
+    std::lock_guard<std::mutex> lock(legacyMutex);
+    char line[256];
+    int length = std::snprintf(line, sizeof(line), "[Server] Client %u (%s) sent %.1f msg/s\n",
+                               playerId, name, rate);
+    std::fwrite(line, 1, length, sink);
+}
+
+// ns per call, averaged over every thread
+template <typename Body>
+double run(int threadCount, int calls, Body body) {
+    std::vector<std::thread> threads;
+    std::vector<double> nsPerCall(threadCount);
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < calls; ++i) body(static_cast<unsigned>(i));
+            std::chrono::duration<double, std::nano> spent = std::chrono::steady_clock::now() - begin;
+            nsPerCall[t] = spent.count() / calls;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    double total = 0;
+    for (double ns : nsPerCall) total += ns;
+    return total / threadCount;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int calls = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::vector<int> threadCounts;
+    for (int i = 2; i < argc; ++i) threadCounts.push_back(std::atoi(argv[i]));
+    if (threadCounts.empty()) threadCounts = {1, 2, 4, 8};
+
+    sink = std::fopen("/dev/null", "w");
+    if (!sink) {
+        std::perror("/dev/null");
+        return 1;
+    }
+    Logger& logger = Logger::instance();
+    logger.setOutput(sink);
+    logger.setSiteRateLimit(0);
+
+    printf("%d calls per thread; ns per call on the calling thread\n", calls);
+    printf("%7s %10s %10s %12s\n", "threads", "LOG", "mutex", "LOG dropped");
+    for (int threadCount : threadCounts) {
+        uint64_t droppedBefore = logger.getDroppedCount();
+        double async = run(threadCount, calls, [](unsigned i) {
+            LOG("[Server] Client %u (%s) sent %.1f msg/s", i, "Player1", i * 0.5);
+        });
+        logger.flush();
+        uint64_t dropped = logger.getDroppedCount() - droppedBefore;
+        double legacy = run(threadCount, calls, [](unsigned i) { legacyLog(i, "Player1", i * 0.5); });
+        printf("%7d %10.1f %10.1f %11.2f%%\n", threadCount, async, legacy,
+               100.0 * dropped / (static_cast<double>(calls) * threadCount));
+        fflush(stdout);
+    }
+    return 0;
+}
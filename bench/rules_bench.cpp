@@ -0,0 +1,97 @@
+// Specialized vs runtime-configured rules: every game mode is stepped twice
+// with the same bots and seeds, once as RulesGame<ModeRules> (constants
+// folded in at compile time) and once as RulesGame<RuntimeRules> holding
+// the same values in memory. Only Game::update is timed; the two runs must
+// also end in the same state.
+//
+// usage: tagpro_rules_bench [ticks per run] [players per lobby...]
+// The table goes to stdout; game logging goes to stderr.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "game/bot.h"
+#include "game/game.h"
+
+namespace {
+
+constexpr uint32_t stepMs = 16;
+
+struct RunResult {
+    double nsPerTick = 0;
+    GameState state;
+};
+
+RunResult run(std::unique_ptr<Game> game, int players, int ticks) {
+    std::vector<Bot> bots;
+    for (int p = 0; p < players; ++p) {
+        uint32_t id = game->addPlayer("Bot" + std::to_string(p + 1), p % 2);
+        bots.emplace_back(id, p);
+    }
+    game->start();
+
+    std::chrono::nanoseconds spent{0};
+    for (int tick = 0; tick < ticks; ++tick) {
+        auto begin = std::chrono::steady_clock::now();
+        game->update(stepMs);
+        spent += std::chrono::steady_clock::now() - begin;
+
+        GameState state = game->getGameState();
+        for (Bot& bot : bots) {
+            float inputX, inputY;
+            bot.think(state, inputX, inputY);
+            game->queuePlayerInput(bot.getPlayerId(), inputX, inputY);
+        }
+    }
+    return {static_cast<double>(spent.count()) / ticks, game->getGameState()};
+}
+
+bool sameState(const GameState& a, const GameState& b) {
+    if (a.redScore != b.redScore || a.blueScore != b.blueScore ||
+        a.redFlag != b.redFlag || a.blueFlag != b.blueFlag ||
+        a.players.size() != b.players.size()) {
+        return false;
+    }
+    for (const auto& [id, player] : a.players) {
+        auto other = b.players.find(id);
+        if (other == b.players.end() || other->second.x != player.x || other->second.y != player.y ||
+            other->second.velocityX != player.velocityX || other->second.velocityY != player.velocityY) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Rules>
+void compare(const char* name, GameMode mode, int players, int ticks) {
+    RunResult specialized = run(std::make_unique<RulesGame<Rules>>(1, 0, mode), players, ticks);
+    RunResult runtime = run(std::make_unique<RulesGame<RuntimeRules>>(1, 0, mode, RuntimeRules::of<Rules>()),
+                            players, ticks);
+    printf("%-12s %7d %14.0f %14.0f %8.2fx %6s\n", name, players,
+           specialized.nsPerTick, runtime.nsPerTick,
+           specialized.nsPerTick > 0 ? runtime.nsPerTick / specialized.nsPerTick : 0.0,
+           sameState(specialized.state, runtime.state) ? "yes" : "NO");
+    fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int ticks = argc > 1 ? std::atoi(argv[1]) : 20000;
+    std::vector<int> playerCounts;
+    for (int i = 2; i < argc; ++i) playerCounts.push_back(std::atoi(argv[i]));
+    if (playerCounts.empty()) playerCounts = {8, 64};
+
+    printf("%d ticks of %u ms per run; update() time in ns per tick\n", ticks, stepMs);
+    printf("%-12s %7s %14s %14s %9s %6s\n",
+           "mode", "players", "specialized", "runtime", "ratio", "same");
+    for (int players : playerCounts) {
+        compare<ClassicRules>("classic", MODE_CLASSIC, players, ticks);
+        compare<NoFrictionRules>("no-friction", MODE_NO_FRICTION, players, ticks);
+        compare<SingleFlagRules>("single-flag", MODE_SINGLE_FLAG, players, ticks);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Tick latency under load: N lobbies of 8 bots each, stepped by the same
+// WorkerPool + TickScheduler pair the server uses. Every tick runs the
+// bots, Game::update and snapshot encoding; its latency is measured from
+// the tick's deadline to its completion.
+//
+// usage: tagpro_tick_bench [seconds per run] [worker threads] [lobby counts...]
+// The table goes to stdout; game logging goes to stderr.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "game/bot.h"
+#include "game/game.h"
+#include "game/worker_pool.h"
+#include "network/protocol.h"
+#include "network/tick_scheduler.h"
+
+namespace {
+
+constexpr int playersPerLobby = 8;
+constexpr int ticksPerSecond = 60;
+
+struct BenchLobby {
+    std::unique_ptr<Game> game;
+    std::vector<Bot> bots;
+    size_t snapshotBytes = 0;
+};
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+void tickLobby(BenchLobby& lobby, uint32_t elapsedMs) {
+    lobby.game->update(elapsedMs);
+    GameState state = lobby.game->getGameState();
+    lobby.snapshotBytes += Protocol::serializeGameState(state).size();
+    for (Bot& bot : lobby.bots) {
+        float inputX, inputY;
+        bot.think(state, inputX, inputY);
+        lobby.game->queuePlayerInput(bot.getPlayerId(), inputX, inputY);
+    }
+}
+
+void runBench(WorkerPool& pool, int lobbyCount, int seconds) {
+    std::vector<std::unique_ptr<BenchLobby>> lobbies;
+    for (int i = 0; i < lobbyCount; ++i) {
+        auto lobby = std::make_unique<BenchLobby>();
+        lobby->game = Game::create(i + 1);
+        for (int p = 0; p < playersPerLobby; ++p) {
+            uint32_t id = lobby->game->addPlayer("Bot" + std::to_string(p + 1), p % 2);
+            lobby->bots.emplace_back(id, i * playersPerLobby + p);
+        }
+        lobby->game->start();
+        lobbies.push_back(std::move(lobby));
+    }
+
+    std::mutex latencyMutex;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(static_cast<size_t>(lobbyCount) * ticksPerSecond * seconds);
+
+    TickScheduler scheduler(pool, std::chrono::microseconds(1000000 / ticksPerSecond));
+    scheduler.setLatencyObserver([&](uint32_t latencyUs) {
+        std::lock_guard<std::mutex> lock(latencyMutex);
+        latencies.push_back(latencyUs);
+    });
+    std::vector<uint64_t> jobs;
+    for (auto& lobby : lobbies) {
+        BenchLobby* raw = lobby.get();
+        jobs.push_back(scheduler.add([raw](uint32_t elapsedMs) { tickLobby(*raw, elapsedMs); }));
+    }
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    uint64_t missed = 0;
+    for (uint64_t job : jobs) missed += scheduler.getStats(job).missedDeadlines;
+    scheduler.stop();
+
+    std::vector<uint32_t> sorted;
+    {
+        std::lock_guard<std::mutex> lock(latencyMutex);
+        sorted = latencies;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t bytes = 0;
+    for (auto& lobby : lobbies) bytes += lobby->snapshotBytes;
+
+    printf("%7d %9zu %8u %8u %8u %8u %8u %9llu %10.1f\n",
+           lobbyCount, sorted.size(),
+           percentile(sorted, 0.50), percentile(sorted, 0.90),
+           percentile(sorted, 0.99), percentile(sorted, 0.999),
+           sorted.empty() ? 0 : sorted.back(),
+           static_cast<unsigned long long>(missed),
+           bytes / 1024.0 / seconds);
+    fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    size_t threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    std::vector<int> lobbyCounts;
+    for (int i = 3; i < argc; ++i) lobbyCounts.push_back(std::atoi(argv[i]));
+    if (lobbyCounts.empty()) lobbyCounts = {1, 10, 100, 250, 500, 1000};
+
+    WorkerPool pool(threads);
+    printf("%zu workers, %d players per lobby, %d Hz, %d s per run; latencies in us\n",
+           pool.size(), playersPerLobby, ticksPerSecond, seconds);
+    printf("%7s %9s %8s %8s %8s %8s %8s %9s %10s\n",
+           "lobbies", "ticks", "p50", "p90", "p99", "p99.9", "max", "missed", "snap KiB/s");
+    for (int lobbyCount : lobbyCounts) {
+        runBench(pool, lobbyCount, seconds);
+    }
+    printf("work steals: %llu\n", static_cast<unsigned long long>(pool.getStolenCount()));
+    return 0;
+}
@@ -34,6 +34,8 @@ When running the program as a server-dedicated instance, there is no GUI interfa
 
 #image("imgs/server-only.png", width: 35%)
 
+A dedicated server hosts many lobbies at once. Players who connect are placed in the first lobby that has not started yet and still has room (8 players); otherwise a new lobby is created for them. A lobby is closed once it has been empty for 30 seconds.
+
 == GUI Application
 === Main Menu
 Upon launch, you'll see the main menu with three options:
@@ -45,7 +47,7 @@ Upon launch, you'll see the main menu with three options:
 
 === Hosting a Game
 1. Click *Host Game*
-2. Configure settings
+2. Configure settings (port, map: *Classic* is the open arena, *Pillars* adds walls; and mode: *Classic*, *No Friction*, or *Single Flag* where red attacks the blue flag and blue defends)
 3. Click *Start Game*
 4. The server starts and you automatically join as the host
 
@@ -63,6 +65,7 @@ Upon launch, you'll see the main menu with three options:
 
 == Lobby Screen
 After connecting, you'll see the lobby with:
+- The lobby number
 - List of connected players
 - *Start Game* button (visible only to host)
 - *Leave Lobby* button
@@ -81,11 +84,13 @@ The game features:
   - The host is player 1 (blue)
 - Team-colored flags (triangles)
 - Score display
+- Kill feed in the bottom left corner: flag pickups, captures and pops, each shown for five seconds
 
 #image("imgs/game-screen.png", width: 90%)
 
 === Controls
 - *W/A/S/D*: Move your player
+- *F3*: Toggle the performance overlay (render FPS, snapshot rate and jitter, bytes in/out, round trip time, server tick and tick duration, input-to-display latency)
 - Movement is physics-based with acceleration and friction
 - Collision with walls and other players is simulated
 
@@ -94,7 +99,7 @@ The game features:
 2. _*Flag Carrying*_: Pick up the enemy flag by touching it
 3. _*Scoring*_: Return captured flag to your own flag location
 4. _*Tagging*_: Tag enemy flag carriers to make them drop the flag
-5. _*Respawn*_: Tagged players respawn at their team's base
+5. _*Respawn*_: Tagged players respawn at their team's base and wait there for three seconds before they can move again
 
 == Exiting the Game
 - Close the window to exit
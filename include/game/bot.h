@@ -0,0 +1,32 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include "game_state.h"
+#include "map.h"
+
+// Scripted player for benchmarks and load tests. It runs for the enemy
+// flag, carries it home and weaves a little on the way so players meet
+// and collide the way real matches do. It steers straight at its target
+// and does not path around walls.
+class Bot {
+public:
+    Bot(uint32_t playerId, uint32_t seed);
+
+    // the input to hold for the next tick, given the latest state
+    void think(const GameState& state, float& inputX, float& inputY);
+
+    uint32_t getPlayerId() const { return playerId; }
+
+private:
+    uint32_t playerId;
+    std::mt19937 rng;
+    float weaveX = 0, weaveY = 0;
+    uint32_t ticksUntilWeave = 0;
+    uint8_t mapId = 0;
+    std::shared_ptr<const Map> map;
+};
+
+#endif // BOT_H
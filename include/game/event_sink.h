@@ -0,0 +1,49 @@
+#ifndef EVENT_SINK_H
+#define EVENT_SINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "game_event.h"
+
+// Takes each tick's events off the tick threads and hands them to a
+// consumer on a thread of its own, by default one that logs them.
+// submit() only copies the records under a short lock; all formatting
+// happens on the sink's thread.
+class EventSink {
+public:
+    using Consumer = std::function<void(uint32_t lobbyId, const GameEvent& event)>;
+
+    explicit EventSink(Consumer consumer = logEvent);
+    ~EventSink(); // delivers what is still pending
+
+    void submit(uint32_t lobbyId, const std::vector<GameEvent>& events);
+    uint64_t getDroppedCount() const { return dropped; }
+
+    static void logEvent(uint32_t lobbyId, const GameEvent& event);
+
+    // events waiting for the consumer before new ones are dropped
+    constexpr static size_t maxPending = 65536;
+
+private:
+    struct Entry {
+        uint32_t lobbyId;
+        GameEvent event;
+    };
+
+    void run();
+
+    Consumer consumer;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<Entry> pending; // guarded by mutex
+    bool stopping = false;      // guarded by mutex
+    std::atomic<uint64_t> dropped{0};
+    std::thread thread;
+};
+
+#endif // EVENT_SINK_H
@@ -1,20 +1,32 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <atomic>
 #include <mutex>
+#include <memory>
+#include <memory_resource>
 #include <queue>
+#include <unordered_map>
+#include <vector>
+#include "game_event.h"
 #include "game_state.h"
+#include "input_buffer.h"
+#include "map.h"
+#include "rules.h"
+#include "tick_arena.h"
+#include "timing_wheel.h"
 
-// for queue of events
-struct PlayerInput {
-    uint32_t playerId;
-    float inputX;
-    float inputY;
-};
+class WorkerPool;
 
+// A lobby's match. The rules-independent parts (players, inputs, timers)
+// live here; the physics and scoring of a step are in RulesGame below,
+// compiled once per game mode.
 class Game {
 public:
-    Game(uint32_t lobbyId);
+    // builds the game for `mode` (unknown modes play classic); the map is
+    // loaded, or shared with other lobbies on it, here
+    static std::unique_ptr<Game> create(uint32_t lobbyId, uint8_t mapId = 0, GameMode mode = MODE_CLASSIC);
+    virtual ~Game() = default;
 
     void start();
     void stop();
@@ -22,45 +34,127 @@ public:
     // player management
     uint32_t addPlayer(const std::string& name, uint8_t team);
     bool removePlayer(uint32_t playerId);
-    void queuePlayerInput(uint32_t playerId, float inputX, float inputY);
+    void queuePlayerInput(uint32_t playerId, float inputX, float inputY, uint32_t sequence = 0, uint32_t clientTick = 0);
     bool setPlayerTeam(uint32_t playerId, uint8_t team); // unused
+    // lets lobbies with at least `threshold` live players resolve
+    // collisions across the pool; results match the serial path exactly
+    void setWorkerPool(WorkerPool* pool, size_t threshold = defaultParallelCollisionThreshold);
 
     // getters
-    GameState getGameState() const { return currentState; }
+    GameState getGameState() const;
     PlayerState* getPlayerState(uint32_t playerId);
     size_t getPlayerCount() const;
     int32_t getNextPlayerId() const;
+    std::unordered_map<uint32_t, InputBufferStats> getInputBufferStats() const;
+    // inputs queued for the next update(); lock-free, for monitoring
+    size_t getInputQueueDepth() const { return inputQueueDepth.load(std::memory_order_relaxed); }
+    const Map& getMap() const { return *map; }
+    GameMode getMode() const { return mode; }
+    // events of the last update(); only valid until the next one, so read
+    // them from the thread that calls update()
+    const std::vector<GameEvent>& getTickEvents() const { return tickEvents; }
+    // approximate bytes held by this game: players, input buffers and
+    // queue, timers, events and tick scratch, by capacity; allocator
+    // overhead is not counted
+    size_t getMemoryUsage() const;
+    // scratch memory for the current tick, taken back when the next
+    // update() begins; same thread rules as getTickEvents()
+    std::pmr::memory_resource* getTickMemory() { return tickArena.resource(); }
+    // runs read(state) under the state lock, for callers that only need to
+    // look at the state and would rather not copy it
+    template <typename Read>
+    void readState(Read&& read) const {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        read(static_cast<const GameState&>(currentState));
+    }
 
     void update(uint32_t deltaTimeMs);
 
+    // the same in every mode; clients draw players at this size
     constexpr static float playerRadius = 15.0f;
-    constexpr static float playerAcceleration = 60.0f;
-    constexpr static float playerMaxSpeed = 1000.0f;
-    constexpr static float playerFriction = 0.98f;
-    constexpr static float playerRestitution = 0.2f;
-    constexpr static float wallRestitution = 0.15f;
-
-    constexpr static float arenaWidth = 800.0f;
-    constexpr static float arenaHeight = 600.0f;
-
-    constexpr static float redFlagX = 100.0f;
-    constexpr static float redFlagY = arenaHeight / 2.0f;
-    constexpr static float blueFlagX = arenaWidth - 100.0f;
-    constexpr static float blueFlagY = arenaHeight / 2.0f;
-private:
-    float getTeamSpawnXLocation(uint8_t team);
-    void applyPhysics(PlayerState& player, float deltaTimeSec);
-    void checkBoundaries(PlayerState& player);
-    void pop(PlayerState& player);
+
+    constexpr static size_t defaultParallelCollisionThreshold = 64;
+    // players closer than this beyond touching share a collision island
+    constexpr static float collisionIslandMargin = playerRadius;
+    constexpr static size_t expectedEventsPerTick = 64; // preallocated, grows if exceeded
+    // bounces off walls followed within one step; corridors beyond this settle at the end
+    constexpr static int maxWallContactsPerStep = 4;
+protected:
+    // a flag carrier touched by an enemy, popped once every island is resolved
+    struct Tag {
+        PlayerState* carrier;
+        uint32_t taggerId;
+    };
+
+    Game(uint32_t lobbyId, uint8_t mapId, GameMode mode);
+
+    // moves, collides and scores every player for one step; called by
+    // update() with stateMutex held, after inputs and timers
+    virtual void step(float deltaTimeSec) = 0;
+
+    void moveToSpawn(PlayerState& player);
+    void recordEvent(GameEventKind kind, const PlayerState& player, uint32_t otherId = 0);
     bool checkCollision(float x1, float y1, float x2, float y2);
-    void resolveCollisions();
-    void updatePlayerVelocity(PlayerState& player, float inputX, float inputY, float deltaTimeSec);
+    bool sweptTouches(const PlayerState& player, float x, float y);
+    // islands and their scratch data live in the tick arena
+    std::pmr::vector<std::pmr::vector<PlayerState*>> buildCollisionIslands(const std::pmr::vector<PlayerState*>& players);
+
+    std::shared_ptr<const Map> map;
+    GameMode mode;
 
     mutable std::mutex stateMutex;
     GameState currentState;
 
     std::queue<PlayerInput> inputQueue;
     mutable std::mutex inputQueueMutex;
+    std::atomic<size_t> inputQueueDepth{0}; // inputQueue.size(), readable without the lock
+
+    // guarded by stateMutex
+    std::unordered_map<uint32_t, InputJitterBuffer> inputBuffers;
+    // game-time timers in milliseconds, so they expire at the same point
+    // of play whatever the tick rate; callbacks run inside update()
+    TimingWheel timers;
+    std::unordered_map<uint32_t, TimingWheel::TimerId> respawnTimers;
+    std::vector<GameEvent> tickEvents;
+    TickArena tickArena; // reset at the start of update()
+
+    WorkerPool* workerPool = nullptr;
+    size_t parallelCollisionThreshold = defaultParallelCollisionThreshold;
 };
 
+// Game specialized on a rules policy (see rules.h).
+template <typename Rules>
+class RulesGame final : public Game {
+public:
+    RulesGame(uint32_t lobbyId, uint8_t mapId = 0, GameMode mode = MODE_CLASSIC, Rules rules = Rules());
+
+    const Rules& getRules() const { return rules; }
+
+private:
+    friend struct GameBenchAccess; // bench/game_bench.cpp times resolveCollisions on its own
+
+    void step(float deltaTimeSec) override;
+    void updatePlayerVelocity(PlayerState& player, float inputX, float inputY, float deltaTimeSec);
+    void applyPhysics(PlayerState& player, float deltaTimeSec);
+    // walks the path from (fromX, fromY) to the player's position, which
+    // took deltaTimeSec, and bounces it off the first wall in reach
+    void checkBoundaries(PlayerState& player, float fromX, float fromY, float deltaTimeSec);
+    void pushOutOfWalls(PlayerState& player);
+    void pop(PlayerState& player, uint32_t taggerId);
+    void resolveCollisions(float deltaTimeSec);
+    void updateFlags(PlayerState& player);
+    void resolveIsland(const std::pmr::vector<PlayerState*>& island, float deltaTimeSec,
+                       std::vector<Tag>& tags);
+    void bounce(PlayerState& player1, PlayerState& player2, float nx, float ny,
+                std::vector<Tag>& tags);
+
+    Rules rules;
+};
+
+// instantiated in game.cpp
+extern template class RulesGame<ClassicRules>;
+extern template class RulesGame<NoFrictionRules>;
+extern template class RulesGame<SingleFlagRules>;
+extern template class RulesGame<RuntimeRules>;
+
 #endif // GAME_H
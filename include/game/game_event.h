@@ -0,0 +1,25 @@
+#ifndef GAME_EVENT_H
+#define GAME_EVENT_H
+
+#include <cstdint>
+
+enum GameEventKind : uint8_t {
+    EVENT_FLAG_TAKEN = 1, // playerId picked up the enemy flag
+    EVENT_CAPTURE = 2,    // playerId brought it home and scored
+    EVENT_POP = 3,        // playerId was tagged by otherId and dropped the flag
+    EVENT_RESPAWN = 4,    // playerId is back in play after a pop
+};
+
+// Something that happened during a tick, recorded as plain data so the
+// tick never formats text; clients get them for the kill feed and the
+// server logs them off the tick thread (see EventSink).
+struct GameEvent {
+    uint32_t tick;
+    GameEventKind kind;
+    uint8_t team;     // playerId's team
+    uint32_t playerId;
+    uint32_t otherId; // the tagger for EVENT_POP, otherwise 0
+    float x, y;       // where playerId was
+};
+
+#endif // GAME_EVENT_H
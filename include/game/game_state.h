@@ -12,21 +12,27 @@ struct PlayerState {
   uint32_t id;
   std::string name;
   float x, y;
+  float prevX, prevY; // position at the start of the current step, for swept collisions
+  float contactX, contactY; // where the step's path last bounced; prevX/prevY if it ran straight
   float velocityX, velocityY;
   uint8_t team;
-  uint32_t respawnTimer;
+  uint32_t respawnTimer; // respawn delay in ms after a tag; non-zero until the player is back in play
   bool connected;
   bool hasFlag;
+  uint32_t lastInputSeq; // sequence of the last input applied, echoed back to the client
+  float inputX, inputY; // held input, applied every tick until the next one arrives
 
-  PlayerState() : id(0), x(0), y(0), velocityX(0), velocityY(0), team(0), respawnTimer(0), connected(false), hasFlag(false) {}
+  PlayerState() : id(0), x(0), y(0), prevX(0), prevY(0), contactX(0), contactY(0), velocityX(0), velocityY(0), team(0), respawnTimer(0), connected(false), hasFlag(false), lastInputSeq(0), inputX(0), inputY(0) {}
   PlayerState(uint32_t id, const std::string& name, uint8_t team)
-      : id(id), name(name), x(0), y(0), velocityX(0), velocityY(0), team(team), respawnTimer(0), connected(true), hasFlag(false) {}
+      : id(id), name(name), x(0), y(0), prevX(0), prevY(0), contactX(0), contactY(0), velocityX(0), velocityY(0), team(team), respawnTimer(0), connected(true), hasFlag(false), lastInputSeq(0), inputX(0), inputY(0) {}
 };
 
 struct GameState {
   uint32_t lobbyId = 0;
   uint32_t redFlag = 0, blueFlag = 0; // wil be player's id when picked up, 0 when not
   uint8_t mapId = 0, redScore = 0, blueScore = 0;
+  uint32_t tick = 0; // number of simulation steps since the game started
+  uint32_t tickDurationUs = 0; // time the server spent on the last step
   std::unordered_map<uint32_t, PlayerState> players;
   PlayerState* getPlayer(uint32_t playerId) {
     auto it = players.find(playerId);
@@ -0,0 +1,62 @@
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// for queue of events
+struct PlayerInput {
+    uint32_t playerId;
+    float inputX;
+    float inputY;
+    uint32_t sequence;   // monotonic per client, older or repeated ones are dropped
+    uint32_t clientTick; // client's 60 Hz frame counter when the input was sampled
+};
+
+struct InputBufferStats {
+    size_t depth = 0;       // inputs waiting for their tick
+    uint32_t delayTicks = 0; // current playout delay
+    float jitterTicks = 0;   // smoothed arrival jitter
+    uint64_t underruns = 0;  // inputs that arrived after their scheduled tick
+    uint64_t overruns = 0;   // inputs dropped because the buffer was full
+};
+
+// Per-client playout buffer for inputs. Inputs are scheduled on the server
+// tick that corresponds to the client tick they were sampled on, plus a
+// delay sized to the client's measured jitter, and released at most one
+// per simulation tick.
+class InputJitterBuffer {
+public:
+    // serverTick is the simulation tick the input is seen on
+    void push(const PlayerInput& input, uint32_t serverTick);
+    // releases the next input scheduled at or before serverTick
+    bool pop(uint32_t serverTick, PlayerInput& input);
+
+    InputBufferStats getStats() const;
+
+    constexpr static size_t capacity = 32;
+    constexpr static uint32_t maxDelayTicks = 8;
+private:
+    struct Entry {
+        PlayerInput input;
+        uint32_t dueTick;
+    };
+    Entry& at(size_t i) { return entries[(head + i) % capacity]; }
+
+    // ring of count entries from head, ordered by client tick; fixed so
+    // the tick never allocates for it
+    std::array<Entry, capacity> entries;
+    size_t head = 0, count = 0;
+
+    uint32_t highestSequence = 0;
+    bool hasOffset = false;
+    float baseOffset = 0;  // smallest observed (serverTick - clientTick)
+    float lastOffset = 0;
+    float jitter = 0;
+    uint32_t delayTicks = 0;
+    uint64_t underruns = 0;
+    uint64_t overruns = 0;
+};
+
+#endif // INPUT_BUFFER_H
@@ -0,0 +1,87 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// On-disk layout of a .tpmap file, little endian:
+// a MapFileHeader, then width * height tile bytes, row by row from the top.
+struct MapFileHeader {
+    char magic[4];      // "TPMP"
+    uint16_t version;   // mapFormatVersion
+    uint16_t tileSize;  // pixels per tile side
+    uint16_t width;     // in tiles
+    uint16_t height;    // in tiles
+    float redFlagX, redFlagY;
+    float blueFlagX, blueFlagY;
+    float redSpawnX, redSpawnY;
+    float blueSpawnX, blueSpawnY;
+};
+
+enum MapTile : uint8_t {
+    TILE_EMPTY = 0,
+    TILE_WALL = 1,
+};
+
+// An arena: its walls, flags and spawns, plus a signed distance field to
+// the nearest wall precomputed at load so that wall tests cost the same
+// however many walls there are. Maps are immutable and shared by every
+// lobby playing them; files are memory mapped rather than copied.
+class Map {
+public:
+    constexpr static uint16_t mapFormatVersion = 1;
+    constexpr static float fieldCellSize = 4.0f; // distance field resolution in pixels
+    constexpr static float fieldRange = 64.0f;   // distances are clamped to this
+
+    ~Map();
+    Map(const Map&) = delete;
+    Map& operator=(const Map&) = delete;
+
+    // map 0 is the built-in empty 800x600 arena; other ids are read from
+    // maps/<id>.tpmap. Falls back to map 0 if the file is missing or bad.
+    static std::shared_ptr<const Map> forId(uint8_t mapId);
+    // loads (or reuses, if another lobby already has it) a map file
+    static std::shared_ptr<const Map> load(const std::string& path);
+
+    float getWidth() const { return float(header.width) * header.tileSize; }
+    float getHeight() const { return float(header.height) * header.tileSize; }
+    uint16_t getTileSize() const { return header.tileSize; }
+    uint16_t getWidthInTiles() const { return header.width; }
+    uint16_t getHeightInTiles() const { return header.height; }
+    bool isWall(int tileX, int tileY) const; // outside the map counts as wall
+
+    float getFlagX(uint8_t team) const;
+    float getFlagY(uint8_t team) const;
+    float getSpawnX(uint8_t team) const;
+    float getSpawnY(uint8_t team) const;
+
+    // signed distance from (x, y) to the nearest wall surface, negative
+    // inside walls, with the unit normal pointing away from that wall
+    float distanceToWall(float x, float y, float& normalX, float& normalY) const;
+
+private:
+    Map() = default;
+    static std::shared_ptr<const Map> classic();
+    void buildDistanceField();
+    float exactDistance(float x, float y, float& normalX, float& normalY) const;
+
+    MapFileHeader header{};
+    const uint8_t* tiles = nullptr;
+    std::vector<uint8_t> ownedTiles; // built-in maps keep their tiles here
+
+    // file mapping, released in the destructor
+    void* mappedData = nullptr;
+    size_t mappedSize = 0;
+
+    struct FieldSample {
+        float distance;
+        float normalX, normalY;
+    };
+    std::vector<FieldSample> field; // (fieldWidth + 1) x (fieldHeight + 1) grid corners
+    size_t fieldWidth = 0, fieldHeight = 0;
+};
+
+#endif // MAP_H
@@ -0,0 +1,53 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <cstdint>
+
+// Game modes a lobby can be created with; each has a rules type below.
+enum GameMode : uint8_t {
+    MODE_CLASSIC = 0,
+    MODE_NO_FRICTION = 1,
+    MODE_SINGLE_FLAG = 2, // red attacks the blue flag, blue defends
+};
+
+// Rules are policies for RulesGame: every constant is known at compile
+// time, so each mode gets its own update loop with the constants folded in
+// and the branches for features it does not use removed.
+struct ClassicRules {
+    constexpr static float playerAcceleration = 60.0f;
+    constexpr static float playerMaxSpeed = 1000.0f;
+    constexpr static float playerFriction = 0.98f; // velocity kept per second; 1 for none
+    constexpr static float playerRestitution = 0.2f;
+    constexpr static float wallRestitution = 0.15f;
+    constexpr static uint32_t respawnDelayMs = 0; // a popped player is held at base this long; 0: back in play at once
+    constexpr static bool redFlagInPlay = true; // false: the red flag is only a capture point
+};
+
+struct NoFrictionRules : ClassicRules {
+    constexpr static float playerFriction = 1.0f;
+};
+
+struct SingleFlagRules : ClassicRules {
+    constexpr static bool redFlagInPlay = false;
+};
+
+// The same rules read from memory at run time, for comparing against the
+// specialized loops (see bench/rules_bench.cpp).
+struct RuntimeRules {
+    float playerAcceleration;
+    float playerMaxSpeed;
+    float playerFriction;
+    float playerRestitution;
+    float wallRestitution;
+    uint32_t respawnDelayMs;
+    bool redFlagInPlay;
+
+    template <typename Rules>
+    static RuntimeRules of() {
+        return {Rules::playerAcceleration, Rules::playerMaxSpeed, Rules::playerFriction,
+                Rules::playerRestitution, Rules::wallRestitution, Rules::respawnDelayMs,
+                Rules::redFlagInPlay};
+    }
+};
+
+#endif // RULES_H
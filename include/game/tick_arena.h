@@ -0,0 +1,46 @@
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Scratch memory for one tick. Allocations from resource() are bumped out
+// of one block and never freed one by one; reset(), called as a tick
+// begins, takes the whole block back. A tick that outgrows the block
+// spills onto the heap, and the next reset() enlarges the block to hold
+// it, so a steady tick stops touching the heap after the first few.
+// Not thread-safe: one thread ticks at a time.
+class TickArena {
+public:
+    explicit TickArena(size_t initialBytes = defaultBytes);
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*arena; }
+    void reset();
+
+    size_t capacity() const { return blockBytes; }
+
+    constexpr static size_t defaultBytes = 64 * 1024;
+
+private:
+    // passes spills through to the heap and remembers how much they took
+    class Spill : public std::pmr::memory_resource {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::unique_ptr<std::byte[]> block;
+    size_t blockBytes;
+    Spill spill;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+};
+
+#endif // TICK_ARENA_H
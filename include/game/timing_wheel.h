@@ -0,0 +1,72 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timing wheel: four wheels of 256 slots, each slot of a wheel
+// spanning a whole turn of the one below (1, 256, 65536 and 2^24 time
+// units). Scheduling and cancelling are O(1); advancing costs the elapsed
+// time units plus the timers that expire, never the timers still pending.
+//
+// Timers fire in deadline order; ties fire in an order that depends only on
+// the sequence of calls, so replays match. Callbacks may schedule and
+// cancel timers, including siblings due at the same time.
+class TimingWheel {
+public:
+    using Callback = std::function<void()>;
+    using TimerId = uint64_t; // 0 is never a valid timer
+
+    explicit TimingWheel(uint64_t now = 0) : current(now) {}
+
+    // runs callback on the first advance that reaches now + delay
+    // (at least one unit after now)
+    TimerId schedule(uint64_t delay, Callback callback);
+    // false if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+    void advance(uint64_t now);
+    void clear();
+
+    uint64_t getTime() const { return current; }
+    size_t size() const { return count; }
+    // bytes the wheel holds, not counting what callbacks capture on the heap
+    size_t getMemoryUsage() const {
+        return sizeof(lists) + nodes.capacity() * sizeof(Node) + freeNodes.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    constexpr static int levels = 4;
+    constexpr static int slotBits = 8;
+    constexpr static uint32_t slotsPerLevel = 1u << slotBits;
+    constexpr static uint32_t slotMask = slotsPerLevel - 1;
+    constexpr static uint32_t nil = UINT32_MAX;
+    constexpr static uint32_t firingList = levels * slotsPerLevel; // timers being run
+
+    struct Node {
+        uint64_t deadline = 0;
+        Callback callback;
+        uint32_t prev = nil, next = nil;
+        uint32_t list = nil; // slot it is linked into, nil when free
+        uint32_t generation = 0;
+    };
+    struct List {
+        uint32_t head = nil, tail = nil;
+    };
+
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t list);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::array<List, levels * slotsPerLevel + 1> lists{};
+    uint64_t current;
+    size_t count = 0;
+};
+
+#endif // TIMING_WHEEL_H
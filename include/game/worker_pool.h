@@ -0,0 +1,63 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, one task deque each. Workers take their own
+// newest task first and steal the oldest task of another worker when they
+// run dry, so a burst of tasks spreads over every core without a shared
+// queue everyone contends on.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkerPool(size_t threadCount = 0); // 0: one per hardware thread
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // callable from any thread; a worker pushes onto its own deque
+    void submit(Task task);
+    // runs body(0..count-1) across the pool and returns when all are done.
+    // The caller works through indices too, so this is safe to call from
+    // inside a task even when every worker is busy.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    size_t size() const { return workers.size(); }
+    uint64_t getStolenCount() const { return stolen; }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<bool> running{true};
+    // submitted but not yet taken; briefly negative when a worker takes a
+    // task before submit() has counted it
+    std::atomic<long> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<uint64_t> stolen{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
+
+#endif // WORKER_POOL_H
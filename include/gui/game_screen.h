@@ -4,10 +4,13 @@
 #include <QWidget>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QTimer>
 #include "../network/client.h"
+#include "../game/game_event.h"
 #include "../game/game_state.h"
+#include "../game/map.h"
 
 class InputHandler {
 public:
@@ -27,15 +30,19 @@ public:
 
     void setLocalClient(Client* client) { localClient = client; }
     void applyGameState(const GameState& state);
+    void applyGameEvents(const std::vector<GameEvent>& events);
 
 protected:
     void keyPressEvent(QKeyEvent* event) override;
     void keyReleaseEvent(QKeyEvent* event) override;
-    void sendPlayerInput();
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    uint32_t sendPlayerInput();
+    void onInputChanged(const QVector2D& before);
 
 private:
     void setupScene();
     void setupScoreDisplay();
+    void setMap(uint8_t mapId);
     void updateScoreDisplay(uint8_t redScore, uint8_t blueScore);
     void updateRedFlag(uint32_t redFlag);
     void updateBlueFlag(uint32_t blueFlag);
@@ -43,6 +50,15 @@ private:
     void removePlayerGraphics(uint32_t playerId);
     QColor getTeamColor(uint8_t team);
 
+    void setupEventFeed();
+    void updateEventFeed();
+    QString getPlayerName(uint32_t playerId) const;
+
+    void setupPerfOverlay();
+    void togglePerfOverlay();
+    void updatePerfOverlay();
+    void recordSnapshotArrival(const GameState& state);
+
     Client* localClient = nullptr;
     QGraphicsScene* scene = nullptr;
     QGraphicsView* view = nullptr;
@@ -53,9 +69,42 @@ private:
     QMap<uint32_t, QGraphicsTextItem*> playerNames;
     QGraphicsPolygonItem* redFlag = nullptr, *blueFlag = nullptr;
 
+    // arena of the game being shown, redrawn when the server's mapId changes
+    uint8_t mapId = 0;
+    std::shared_ptr<const Map> map = Map::forId(0);
+    QGraphicsLineItem* centerLine = nullptr;
+    QList<QGraphicsRectItem*> wallGraphics;
+
     QGraphicsTextItem* redScoreText = nullptr;
     QGraphicsTextItem* blueScoreText = nullptr;
+    QGraphicsTextItem* blueLabel = nullptr;
     QGraphicsRectItem* scoreBackground = nullptr;
+
+    // kill feed: the last few flag events, each shown for eventFeedMs
+    QGraphicsTextItem* eventFeedText = nullptr;
+    QStringList eventFeed;
+    constexpr static int eventFeedLines = 4;
+    constexpr static int eventFeedMs = 5000;
+
+    // performance overlay (F3)
+    QGraphicsTextItem* perfText = nullptr;
+    QGraphicsRectItem* perfBackground = nullptr;
+    QTimer* perfTimer = nullptr;
+    QElapsedTimer perfClock;
+    qint64 lastPerfUpdateMs = 0;
+    uint64_t lastBytesSent = 0, lastBytesReceived = 0;
+    int framesRendered = 0;
+    int snapshotsReceived = 0;
+    qint64 lastSnapshotMs = -1;
+    double snapshotIntervalMs = 0, snapshotJitterMs = 0; // smoothed as in RFC 3550
+    uint32_t serverTick = 0, serverTickDurationUs = 0;
+
+    // input-to-display latency: time from an input change to the first
+    // snapshot whose lastInputSeq acknowledges it
+    bool inputPending = false;
+    uint32_t pendingInputSeq = 0;
+    qint64 pendingInputMs = 0;
+    double inputLatencyMs = -1;
 };
 
 #endif
@@ -17,12 +17,14 @@ class LobbyScreen : public QWidget {
   void updatePlayerList(const QStringList& players);
   void clearPlayerList();
   void setHost(bool h);
+  void setLobbyId(uint32_t id);
 
  signals:
   void leaveLobbyRequested();
   void lobbyHostStartGameRequested();
 
  private:
+  QLabel* title;
   QListWidget* playerList;
   QPushButton* leaveButton;
   QPushButton* startGameBtn = nullptr;
@@ -47,7 +49,7 @@ private slots:
   void onJoinClicked();
   void onBackClicked();
 
-  void onHostCreateLobby(QString port);
+  void onHostCreateLobby(QString port, uint8_t mapId, GameMode mode);
   void onClientJoinGame(QString ip, QString port);
 
 private:
@@ -1,10 +1,16 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <thread>
 #include <mutex>
 
+#include "clock_sync.h"
 #include "network.h"
+#include "protocol.h"
+#include "transport.h"
 
 class Client {
 public:
@@ -15,30 +21,58 @@ public:
     ~Client();
 
     void connect(int port, const char* ip);
+    // joins over an already established connection, e.g. Server::connectLocal()
+    void connect(std::shared_ptr<Connection> connection);
     void disconnect();
 
     void sendMessage(const std::string& message);
-    void sendPlayerInput(float x, float y);
+    uint32_t sendPlayerInput(float x, float y); // returns the input's sequence number
+    void sendPing();
+    // leave the current lobby for a new one, or for an existing one by id
+    void createLobby();
+    void joinLobby(uint32_t lobbyId);
 
     void setMessageCallback(MessageCallback callback);
     void setConnectionCallback(ConnectionCallback callback);
     void clearCallbacks();
 
     uint32_t getPlayerId() const { return playerId; }
+    uint32_t getLobbyId() const { return lobbyId; }
+    uint32_t getClientTick() const; // 60 Hz frames since connecting
+
+    // traffic counters
+    uint64_t getBytesSent() const { return connection ? connection->getBytesSent() : 0; }
+    uint64_t getBytesReceived() const { return connection ? connection->getBytesReceived() : 0; }
+
+    // smoothed round trip, its jitter and the server clock, from periodic pings
+    double getRttMs() const { return clockSync.getRttMs(); }
+    double getJitterMs() const { return clockSync.getJitterMs(); }
+    int64_t getServerClockOffsetUs() const { return clockSync.getOffsetUs(); }
+    uint64_t getServerTimeUs() const { return clockSync.remoteNowUs(); }
+
+    constexpr static int pingIntervalMs = 1000;
 
 private:
-    void createSocket();
+    SOCKET createSocket();
     void receiveLoop();
-    void processIncomingData();
+    void processMessage(const std::string& message);
+    void pingLoop();
 
-    SOCKET clientSocket = INVALID_SOCKET;
+    std::shared_ptr<Connection> connection; // set once per Client
+    bool socketsInitialized = false; // only TCP connections need initSockets()
     std::thread receivingThread;
+    std::thread pingThread;
+    std::chrono::steady_clock::time_point connectTime;
 
     std::atomic<bool> isRunning{false};
     std::atomic<uint32_t> playerId{0};
+    std::atomic<uint32_t> lobbyId{0};
+    std::mutex inputMutex;
+    uint32_t inputSequence = 0;
+    std::deque<Protocol::InputSample> inputHistory; // newest first
+    double simulatedInputLoss = 0; // fraction of input packets dropped, for testing
 
-    std::mutex bufferMutex;
-    std::string receiveBuffer;
+    ClockSync clockSync;
 
     std::mutex callbackMutex;
     MessageCallback messageCallback;
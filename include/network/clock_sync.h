@@ -0,0 +1,44 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// Round trip and clock offset estimate for one peer, fed by PING/PONG
+// exchanges. Each exchange gives the four NTP timestamps:
+//   t0 ping sent (local), t1 ping received (remote),
+//   t2 pong sent (remote), t3 pong received (local)
+class ClockSync {
+public:
+    static uint64_t nowUs(); // local steady clock, microseconds
+
+    // returns false when the sample was rejected as an outlier
+    bool addSample(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3);
+
+    double getRttMs() const;
+    double getJitterMs() const;
+    int64_t getOffsetUs() const;  // remote clock minus local clock
+    uint64_t remoteNowUs() const; // current time on the remote clock
+    uint64_t getSampleCount() const;
+    uint64_t getRejectedCount() const;
+
+    constexpr static size_t windowSize = 8;
+private:
+    struct Sample {
+        int64_t rttUs;
+        int64_t offsetUs;
+    };
+
+    mutable std::mutex mutex;
+    std::deque<Sample> window; // most recent accepted samples
+    double smoothedRttUs = 0;
+    double rttVarianceUs = 0;
+    int64_t offsetUs = 0;
+    uint64_t samples = 0;
+    uint64_t rejected = 0;
+    int consecutiveRejects = 0;
+};
+
+#endif // CLOCK_SYNC_H
@@ -0,0 +1,10 @@
+#ifndef DEDICATED_SERVER_H
+#define DEDICATED_SERVER_H
+
+// Runs a headless server until SIGINT or SIGTERM and returns the process
+// exit code. The arguments are those after `--server`:
+// [PORT] [MAP] [MODE] [--profile] [--metrics-port PORT] [--tick-rate HZ]
+// [--memory-accounting] [--max-connection-kb KB]
+int runDedicatedServer(int argc, char* argv[]);
+
+#endif // DEDICATED_SERVER_H
@@ -0,0 +1,37 @@
+#ifndef HTTP_ENDPOINT_H
+#define HTTP_ENDPOINT_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include "network.h"
+
+// Minimal HTTP/1.0 listener on 127.0.0.1 for monitoring scrapes. One
+// thread answers GET requests one at a time and closes each connection;
+// a client that stalls is dropped after requestTimeoutMs.
+class HttpEndpoint {
+public:
+    // fills the body and content type for a GET of path; false answers 404
+    using Handler = std::function<bool(const std::string& path, std::string& body, std::string& contentType)>;
+
+    ~HttpEndpoint();
+
+    bool start(unsigned int port, Handler handler);
+    void stop();
+    bool isRunning() const { return running; }
+
+    constexpr static int requestTimeoutMs = 1000;
+    constexpr static size_t maxRequestBytes = 8192;
+
+private:
+    void serve();
+    void answer(SOCKET client);
+
+    Handler handler;
+    SOCKET listenSocket = INVALID_SOCKET;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+#endif // HTTP_ENDPOINT_H
@@ -0,0 +1,212 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "spsc_queue.h"
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_ERROR = 3,
+};
+
+// calls below this level are compiled out, argument evaluation included
+#ifndef TAGPRO_MIN_LOG_LEVEL
+#define TAGPRO_MIN_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// One LOG call site: its format and level, plus the budget that keeps a
+// site repeating in a loop from flooding the output. Sites live in static
+// storage, so records only need to point at them.
+struct LogSite {
+    constexpr LogSite(const char* format, LogLevel level) : format(format), level(level) {}
+
+    const char* format;
+    LogLevel level;
+    std::atomic<int64_t> windowSecond{-1};
+    std::atomic<uint32_t> inWindow{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+// A log call as it is queued: the site, the time and the arguments in
+// binary (a type tag, then the value; strings are copied). Nothing is
+// formatted until the flusher thread writes it out.
+struct LogRecord {
+    enum ArgType : uint8_t { ARG_SIGNED, ARG_UNSIGNED, ARG_DOUBLE, ARG_STRING, ARG_POINTER };
+    constexpr static size_t argBytes = 232; // keeps a record at 256 bytes
+
+    const LogSite* site = nullptr;
+    uint64_t timeNs = 0;          // steady clock, orders records across threads
+    uint32_t suppressedBefore = 0; // repeats of the site dropped since it last got through
+    uint16_t size = 0;             // bytes of args in use
+    char args[argBytes];
+};
+
+class LogArgWriter {
+public:
+    explicit LogArgWriter(LogRecord& record) : record(record) {}
+
+    template <typename T>
+    void add(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            put(LogRecord::ARG_UNSIGNED, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_enum_v<T>) {
+            add(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            put(LogRecord::ARG_SIGNED, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<T>) {
+            put(LogRecord::ARG_UNSIGNED, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            put(LogRecord::ARG_DOUBLE, static_cast<double>(value));
+        } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+            putString(value);
+        } else if constexpr (std::is_pointer_v<T>) {
+            put(LogRecord::ARG_POINTER, reinterpret_cast<uintptr_t>(value));
+        } else {
+            static_assert(std::is_pointer_v<T>, "LOG arguments must be numbers, enums, C strings or pointers");
+        }
+    }
+
+private:
+    template <typename V>
+    void put(LogRecord::ArgType type, V value) {
+        if (record.size + 1 + sizeof(V) > LogRecord::argBytes) return; // out of room: prints as <?>
+        record.args[record.size++] = static_cast<char>(type);
+        std::memcpy(record.args + record.size, &value, sizeof(V));
+        record.size += sizeof(V);
+    }
+    void putString(const char* value);
+
+    LogRecord& record;
+};
+
+// Asynchronous logger behind LOG and friends. Each thread appends records
+// to a lock-free ring of its own; a background thread collects them every
+// few milliseconds, orders them by time, formats them and writes them out
+// in one go; a ring filling up wakes it early. A full ring drops the
+// record (counted and reported) instead of blocking the caller. Each call
+// site may log getSiteRateLimit() messages a second; the rest are counted
+// and noted on the next one that gets through.
+class Logger {
+public:
+    static Logger& instance() {
+        static Logger* logger = create(); // never destroyed: threads may log during exit
+        return *logger;
+    }
+
+    template <typename... Args>
+    void write(LogSite& site, const Args&... args) {
+        uint64_t now = nowNs();
+        uint32_t suppressedBefore = 0;
+        if (!admit(site, now, suppressedBefore)) return;
+        LogRecord record;
+        record.site = &site;
+        record.timeNs = now;
+        record.suppressedBefore = suppressedBefore;
+        LogArgWriter writer(record);
+        (writer.add(args), ...);
+        submit(record);
+    }
+
+    // returns once everything logged before the call has been written
+    void flush();
+    // where lines go, stderr by default
+    void setOutput(FILE* out);
+    // messages per call site per second, 0 for no limit
+    void setSiteRateLimit(uint32_t perSecond) { siteRateLimit = perSecond; }
+    uint32_t getSiteRateLimit() const { return siteRateLimit; }
+    uint64_t getDroppedCount() const { return dropped; }
+    // bytes of the per-thread record rings, including those of exited
+    // threads not yet drained
+    size_t getBufferBytes();
+
+    // renders a record as printf would have, without a trailing newline
+    static void format(const LogRecord& record, std::string& out);
+
+    // 16 KiB per logging thread, and the server still runs one per client;
+    // the flusher drains it every flushIntervalMs, and sooner once half full
+    constexpr static size_t recordsPerThread = 64;
+    constexpr static uint32_t defaultSiteRateLimit = 50;
+    constexpr static int flushIntervalMs = 5;
+
+private:
+    struct ThreadBuffer {
+        SpscQueue<LogRecord> queue{recordsPerThread};
+        std::atomic<bool> abandoned{false}; // its thread has exited
+    };
+
+    Logger();
+    static Logger* create();
+    static void shutdownAtExit();
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool admit(LogSite& site, uint64_t now, uint32_t& suppressedBefore) {
+        uint32_t limit = siteRateLimit.load(std::memory_order_relaxed);
+        if (limit == 0) return true;
+        int64_t second = static_cast<int64_t>(now / 1000000000);
+        int64_t current = site.windowSecond.load(std::memory_order_relaxed);
+        if (current != second &&
+            site.windowSecond.compare_exchange_strong(current, second, std::memory_order_relaxed)) {
+            site.inWindow.store(0, std::memory_order_relaxed);
+            suppressedBefore = site.suppressed.exchange(0, std::memory_order_relaxed);
+        }
+        if (site.inWindow.fetch_add(1, std::memory_order_relaxed) >= limit) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void submit(const LogRecord& record);
+    ThreadBuffer* localBuffer();
+    void flushLoop();
+    void drainAndWrite();
+    void writeLine(const LogRecord& record); // synchronous, once the flusher is gone
+
+    std::mutex buffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // guarded by buffersMutex
+
+    std::mutex flushMutex;
+    std::condition_variable flushWake, flushDone;
+    uint64_t flushRequested = 0, flushCompleted = 0; // guarded by flushMutex
+    bool stopping = false;                           // guarded by flushMutex
+
+    std::mutex outputMutex; // serializes writes to output
+    FILE* output = stderr;
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> wakeRequested{false}; // a ring is filling up
+    std::atomic<uint32_t> siteRateLimit{defaultSiteRateLimit};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t droppedReported = 0; // flusher only
+    std::thread flusher;
+};
+
+#define TAGPRO_LOG(level, fmt, ...) \
+    do { \
+        if constexpr ((level) >= TAGPRO_MIN_LOG_LEVEL) { \
+            static LogSite logSite("" fmt, level); \
+            Logger::instance().write(logSite, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(fmt, ...) TAGPRO_LOG(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG(fmt, ...) TAGPRO_LOG(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) TAGPRO_LOG(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) TAGPRO_LOG(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif // LOGGER_H
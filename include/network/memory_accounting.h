@@ -0,0 +1,58 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <atomic>
+#include <cstddef>
+
+// What memory is charged to.
+enum MemorySubsystem {
+    MEMORY_GAME_STATE,     // players, input buffers, timers and tick scratch of every game
+    MEMORY_CLIENT_BUFFERS, // connections' receive buffers and sends not yet taken by the peer
+    MEMORY_SNAPSHOTS,      // the last GAME_STATE of every lobby
+    MEMORY_LOGGING,        // per-thread log record rings
+    MEMORY_SUBSYSTEM_COUNT
+};
+
+struct MemoryStats {
+    size_t live = 0;
+    size_t peak = 0;
+};
+
+// Live and high-water bytes of one owner (a lobby, a connection or a
+// whole subsystem). The owner reports its current footprint with set();
+// the change is passed on to the parent, so a subsystem's total is the
+// sum of its owners'. Any thread may set or read.
+class MemoryAccount {
+public:
+    explicit MemoryAccount(MemoryAccount* parent = nullptr) : parent(parent) {}
+    ~MemoryAccount() { set(0); }
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    void set(size_t bytes);
+    size_t getLive() const { return live.load(std::memory_order_relaxed); }
+    size_t getPeak() const { return peak.load(std::memory_order_relaxed); }
+    MemoryStats getStats() const { return {getLive(), getPeak()}; }
+
+private:
+    void add(size_t bytes);
+    void raisePeak(size_t bytes);
+    void remove(size_t bytes) { live.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    MemoryAccount* parent;
+    std::atomic<size_t> live{0};
+    std::atomic<size_t> peak{0};
+};
+
+// Accounting is opt-in: footprints are only measured, reported and held
+// to their caps while it is enabled. The counters behind them are kept
+// either way; measuring is the part that costs.
+namespace MemoryAccounting {
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    MemoryAccount& total(MemorySubsystem subsystem);
+    const char* name(MemorySubsystem subsystem);
+}
+
+#endif // MEMORY_ACCOUNTING_H
@@ -0,0 +1,98 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory_accounting.h"
+#include "transport.h"
+
+// Per-lobby values written by the lobby's tick and read by scrapes.
+struct LobbyGauges {
+    std::atomic<uint32_t> inputQueueDepth{0}; // inputs waiting when the last tick began
+    std::atomic<uint32_t> lastTickUs{0};
+    // measured by each tick while memory accounting is on
+    MemoryAccount gameMemory{&MemoryAccounting::total(MEMORY_GAME_STATE)};
+    MemoryAccount snapshotMemory{&MemoryAccounting::total(MEMORY_SNAPSHOTS)};
+};
+
+// Per-client counters written by the client's thread and read by scrapes.
+struct ClientGauges {
+    std::atomic<uint64_t> rateLimited{0}; // messages its flood guard dropped
+};
+
+// Messages and payload bytes of one direction, indexed by the type byte.
+struct MessageTraffic {
+    std::array<std::atomic<uint64_t>, 256> messages{};
+    std::array<std::atomic<uint64_t>, 256> bytes{};
+};
+
+// Server counters laid out so a scrape needs none of the server's locks:
+// traffic and tick timings are atomics, and the clients and lobbies are an
+// immutable roster the server republishes, under the lock it already
+// holds, whenever one joins, moves or leaves.
+class ServerMetrics {
+public:
+    struct ClientEntry {
+        uint32_t lobbyId;
+        uint32_t playerId;
+        std::string ip;
+        std::shared_ptr<Connection> connection; // send queue depth and byte counts
+        std::shared_ptr<ClientGauges> gauges;
+    };
+    struct LobbyEntry {
+        uint32_t lobbyId;
+        size_t players;
+        bool gameRunning;
+        std::shared_ptr<LobbyGauges> gauges;
+    };
+    struct Roster {
+        std::vector<ClientEntry> clients;
+        std::vector<LobbyEntry> lobbies;
+    };
+
+    ServerMetrics();
+
+    void recordReceived(const std::string& message) { record(received, message); }
+    void recordSent(const std::string& message) { record(sent, message); }
+    void recordTick(uint32_t durationUs);
+    void recordMemoryCapDisconnect() { memoryCapDisconnects.fetch_add(1, std::memory_order_relaxed); }
+    // a message dropped by a client's rate limits, before it was parsed
+    void recordRateLimited(const std::string& message) { record(rateLimited, message); }
+    void recordFloodDisconnect() { floodDisconnects.fetch_add(1, std::memory_order_relaxed); }
+    // a player list request answered by a reply already due this tick
+    void recordPlayerListCoalesced() { playerListsCoalesced.fetch_add(1, std::memory_order_relaxed); }
+    void publishRoster(Roster roster);
+
+    // Prometheus text exposition format 0.0.4
+    std::string renderPrometheus(uint64_t tickOverruns) const;
+    std::string renderJson(uint64_t tickOverruns) const;
+
+    // upper bounds of the tick duration histogram, in microseconds
+    constexpr static std::array<uint32_t, 9> tickBucketsUs = {250, 500, 1000, 2000, 4000, 8000, 16000, 33000, 66000};
+
+private:
+    static void record(MessageTraffic& traffic, const std::string& message) {
+        if (message.empty()) return;
+        uint8_t type = static_cast<uint8_t>(message[0]);
+        traffic.messages[type].fetch_add(1, std::memory_order_relaxed);
+        traffic.bytes[type].fetch_add(message.size(), std::memory_order_relaxed);
+    }
+    std::shared_ptr<const Roster> loadRoster() const { return std::atomic_load(&roster); }
+
+    std::chrono::steady_clock::time_point startTime;
+    MessageTraffic received, sent, rateLimited;
+    std::array<std::atomic<uint64_t>, tickBucketsUs.size() + 1> tickBuckets{}; // last one is +Inf
+    std::atomic<uint64_t> tickCount{0};
+    std::atomic<uint64_t> tickTotalUs{0};
+    std::atomic<uint64_t> memoryCapDisconnects{0};
+    std::atomic<uint64_t> floodDisconnects{0};
+    std::atomic<uint64_t> playerListsCoalesced{0};
+    std::shared_ptr<const Roster> roster; // only through std::atomic_load/atomic_store
+};
+
+#endif // METRICS_H
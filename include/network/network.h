@@ -3,13 +3,10 @@
 
 #pragma once
 
-#include <QDebug>
-#include <mutex>
-
-extern std::mutex consoleMutex;
-#define LOG(fmt, ...) \
-    { std::lock_guard<std::mutex> lock(consoleMutex); \
-      qInfo().noquote() << QString().asprintf(fmt, ##__VA_ARGS__); }
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "logger.h"
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -23,12 +20,26 @@ extern std::mutex consoleMutex;
         return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
     }
     inline void cleanupSockets() { WSACleanup(); }
+    // bytes sent but not yet acknowledged by the peer; not available here
+    inline size_t unsentSocketBytes(SOCKET) { return 0; }
+    // the last socket call's error, for log messages
+    inline const char* lastSocketError() {
+        static thread_local char text[32];
+        snprintf(text, sizeof(text), "WSA error %d", WSAGetLastError());
+        return text;
+    }
 #else // _WIN32
     #include <sys/socket.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <sys/select.h>
+    #include <sys/uio.h>
     #include <arpa/inet.h>
     #include <unistd.h>
+    #ifdef __linux__
+        #include <linux/sockios.h>
+        #include <sys/ioctl.h>
+    #endif
 
     using SOCKET = int;
     #define INVALID_SOCKET -1
@@ -38,5 +49,15 @@ extern std::mutex consoleMutex;
     inline void closeSocket(SOCKET sock) { close(sock); }
     inline bool initSockets() { return true; }
     inline void cleanupSockets() {}
+    inline const char* lastSocketError() { return strerror(errno); }
+    // bytes sent but not yet acknowledged by the peer (Linux only)
+    inline size_t unsentSocketBytes(SOCKET sock) {
+    #ifdef SIOCOUTQ
+        int bytes = 0;
+        if (sock != INVALID_SOCKET && ioctl(sock, SIOCOUTQ, &bytes) == 0 && bytes > 0) return bytes;
+    #endif
+        (void)sock;
+        return 0;
+    }
 #endif // _WIN32
 #endif // NETWORK_H
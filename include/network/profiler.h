@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Durations of one zone over the profiler's rolling window. Bucket 0
+// counts calls under 1 us, bucket i those in [2^(i-1), 2^i) us.
+struct ZoneHistogram {
+    constexpr static size_t bucketCount = 24;
+
+    std::string name;
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    std::array<uint64_t, bucketCount> buckets{};
+
+    // upper bound of the bucket holding the p-th call, in microseconds
+    uint64_t percentileUs(double p) const;
+};
+
+// Scoped timing zones for the tick path. While disabled a zone costs one
+// relaxed load. While enabled every zone that closes is written to a ring
+// of the thread's recent zones, for Chrome trace export, and counted in
+// the thread's histograms; neither takes a lock.
+class Profiler {
+public:
+    static void setEnabled(bool on);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    static uint16_t registerZone(const char* name);
+    static void record(uint16_t zone, uint64_t startNs, uint64_t endNs);
+
+    // the zones still in the rings, as Chrome trace-event JSON
+    // (chrome://tracing, ui.perfetto.dev); false if the file cannot be written
+    static bool writeChromeTrace(const std::string& path);
+    // every zone over the last histogramWindowSec to 2 * histogramWindowSec
+    static std::vector<ZoneHistogram> getHistograms();
+
+    // safe to call from a signal handler; the owner of the main loop
+    // polls takeDumpRequest() and writes the trace
+    static void requestDump() { dumpRequested.store(true, std::memory_order_relaxed); }
+    static bool takeDumpRequest() { return dumpRequested.exchange(false, std::memory_order_relaxed); }
+    static bool isDumpRequested() { return dumpRequested.load(std::memory_order_relaxed); }
+
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr static size_t eventsPerThread = 16384; // zones kept for the trace, per thread
+    constexpr static size_t maxZones = 64;
+    constexpr static int histogramWindowSec = 10;
+
+private:
+    inline static std::atomic<bool> enabled{false};
+    inline static std::atomic<bool> dumpRequested{false};
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(uint16_t zone) : zone(zone), startNs(Profiler::isEnabled() ? Profiler::nowNs() : 0) {}
+    ~ProfileZone() {
+        if (startNs) Profiler::record(zone, startNs, Profiler::nowNs());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    uint16_t zone;
+    uint64_t startNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing scope under `name` (a string literal)
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_CONCAT(profileZoneId, __LINE__) = Profiler::registerZone(name); \
+    ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__))
+
+#endif // PROFILER_H
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include "network.h"
+#include "../game/game_event.h"
 #include "../game/game_state.h"
 
 namespace Protocol {
@@ -18,17 +19,38 @@ namespace Protocol {
         PLAYER_LEFT = 0x06, // TODO
         MARK_CLIENT_HOST = 0x07,
         REQUEST_START_GAME = 0x08,
+        PING = 0x09, // sent by either side, carries the sender's timestamp
+        PONG = 0x0a, // echoes the PING timestamp plus receive and send times
+        CREATE_LOBBY = 0x0b, // client asks for a new lobby and becomes its host
+        JOIN_LOBBY = 0x0c, // client asks to move into a lobby by id
+        LOBBY_JOINED = 0x0d, // tells a client which lobby it is in
+        GAME_EVENTS = 0x0e, // flag, capture and pop events of one tick
         SERVER_SHUTDOWN = 0xff,
     };
 
+    // one entry of the input history carried by every PLAYER_INPUT
+    struct InputSample {
+        uint32_t sequence;
+        uint32_t clientTick;
+        float inputX, inputY;
+    };
+    constexpr size_t inputRedundancy = 4; // inputs repeated per packet
+    constexpr uint32_t clientTickRate = 60; // InputSample::clientTick counts frames at this rate
+
     std::string serializeGameState(const GameState& state);
+    // the same into out, reusing its capacity
+    void serializeGameState(const GameState& state, std::string& out);
     bool deserializeGameState(const std::string& data, GameState& state);
 
+    std::string serializeGameEvents(uint32_t lobbyId, const std::vector<GameEvent>& events);
+    bool deserializeGameEvents(const std::string& data, uint32_t& lobbyId, std::vector<GameEvent>& events);
+
     std::string serializePlayerList(const std::vector<std::string>& players);
     std::vector<std::string> deserializePlayerList(const std::string& data);
 
-    std::string serializePlayerInput(uint32_t playerId, float inputX, float inputY);
-    bool deserializePlayerInput(const std::string& data, uint32_t& playerId, float& inputX, float& inputY);
+    // samples are ordered newest first with consecutive sequence numbers
+    std::string serializePlayerInput(uint32_t playerId, const std::vector<InputSample>& samples);
+    bool deserializePlayerInput(const std::string& data, uint32_t& playerId, std::vector<InputSample>& samples);
 
     std::string serializePlayerJoined(uint32_t playerId);
     bool deserializePlayerJoined(const std::string& data, uint32_t& playerId);
@@ -36,13 +58,38 @@ namespace Protocol {
     std::string serializeServerShutdown();
     bool deserializeServerShutdown(const std::string& data);
 
+    std::string serializePing(uint64_t timestampUs);
+    bool deserializePing(const std::string& data, uint64_t& timestampUs);
+
+    std::string serializePong(uint64_t pingSentUs, uint64_t pingReceivedUs, uint64_t pongSentUs);
+    bool deserializePong(const std::string& data, uint64_t& pingSentUs, uint64_t& pingReceivedUs, uint64_t& pongSentUs);
+
+    std::string serializeCreateLobby();
+    std::string serializeJoinLobby(uint32_t lobbyId);
+    bool deserializeJoinLobby(const std::string& data, uint32_t& lobbyId);
+    std::string serializeLobbyJoined(uint32_t lobbyId);
+    bool deserializeLobbyJoined(const std::string& data, uint32_t& lobbyId);
+
     std::string serializeMarkClientHost();
     std::string serializeRequestStartGame();
 
+    // frames are "<payload length in decimal>:<payload>"
+    constexpr size_t maxMessageBytes = 1 << 20; // larger frames are refused, so a buffer never waits for more
+    constexpr size_t maxLengthDigits = 7;       // enough for maxMessageBytes
+
+    enum FrameStatus {
+        FRAME_READY,      // message holds the next payload, removed from buffer
+        FRAME_INCOMPLETE, // wait for more bytes
+        FRAME_MALFORMED,  // not a length header or over maxMessageBytes; the stream cannot be resynced
+    };
+
     std::string frameMessage(const std::string& data);
-    bool extractMessage(std::string& buffer, std::string& message);
+    FrameStatus extractMessage(std::string& buffer, std::string& message);
 
     bool sendRaw(const char* msg, SOCKET socket);
+    // frames and sends data without building the framed copy; returns the
+    // bytes written, 0 on failure
+    size_t sendFramed(const std::string& data, SOCKET socket);
 }
 
 #endif // PROTOCOL_H
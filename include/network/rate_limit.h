@@ -0,0 +1,65 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Holds up to burst tokens and refills at ratePerSec; each admitted event
+// takes one.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(float ratePerSec = 0, float burst = 0) : rate(ratePerSec), burst(burst), tokens(burst) {}
+
+    bool take(Clock::time_point now) {
+        if (last != Clock::time_point()) {
+            float elapsedSec = std::chrono::duration<float>(now - last).count();
+            tokens = std::min(burst, tokens + elapsedSec * rate);
+        }
+        last = now;
+        if (tokens < 1) return false;
+        tokens -= 1;
+        return true;
+    }
+
+private:
+    float rate, burst, tokens;
+    Clock::time_point last;
+};
+
+// Message limits of one client, by message type, checked on the type byte
+// before anything is parsed. A message over its limit is dropped and
+// costs the client a strike; a client that runs out of strikes is
+// flooding persistently and gets disconnected. Only the client's own
+// thread calls admit().
+class FloodGuard {
+public:
+    enum Verdict { ADMIT, DROP, DISCONNECT };
+
+    struct Limit {
+        uint8_t type;
+        float ratePerSec;
+        float burst;
+    };
+    // Client sends inputs when they change, at most once a 60 Hz frame,
+    // and pongs once a second; nothing it sends should come near these
+    static const std::array<Limit, 7> limits;
+    static const Limit otherLimit; // any type not listed
+    constexpr static float strikesPerSec = 5;
+    constexpr static float strikeBurst = 50;
+
+    FloodGuard();
+    // DISCONNECT is returned once; every message after it is dropped
+    Verdict admit(uint8_t type, TokenBucket::Clock::time_point now);
+
+private:
+    std::array<TokenBucket, 8> buckets; // limits in order, then otherLimit
+    TokenBucket strikes{strikesPerSec, strikeBurst};
+    bool flooding = false;
+};
+
+#endif // RATE_LIMIT_H
@@ -4,71 +4,197 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
+#include "../game/event_sink.h"
 #include "../game/game.h"
+#include "clock_sync.h"
+#include "http_endpoint.h"
+#include "metrics.h"
 #include "network.h"
+#include "rate_limit.h"
+#include "tick_scheduler.h"
+#include "transport.h"
 
-extern std::mutex consoleMutex;
+struct Lobby;
 
 struct ClientInfo {
-    SOCKET socket;
-    uint32_t playerId;
+    std::shared_ptr<Connection> connection;
+    uint32_t playerId = 0; // id inside the current lobby's game
+    Lobby* lobby = nullptr; // changed under clientsMutex by this client's own thread
     std::thread thread;
     std::atomic<bool> running{true}; // Flag to track status
-    std::string receiveBuffer;
     std::string clientIP;
+    ClockSync clockSync; // round trip to this client, from server pings
+    FloodGuard floodGuard; // only used by this client's thread
+    std::shared_ptr<ClientGauges> gauges = std::make_shared<ClientGauges>(); // shared with metrics scrapes
 
     // Helper to make moving this struct into a vector easier
-    ClientInfo(SOCKET s, uint32_t id, const std::string& ip = "")
-      : socket(s), playerId(id), clientIP(ip) {}
+    ClientInfo(std::shared_ptr<Connection> c, const std::string& ip = "")
+      : connection(std::move(c)), clientIP(ip) {}
 
     // Disable copying (threads can't be copied), allow moving
     ClientInfo(const ClientInfo&) = delete;
 };
 
+// One match: its game, roster and host. Lobbies live in the server's
+// registry until they have been empty for lobbyIdleTimeoutSec.
+struct Lobby {
+    uint32_t id;
+    std::unique_ptr<Game> game;
+    std::vector<ClientInfo*> members; // guarded by Server::clientsMutex
+    ClientInfo* host = nullptr;       // guarded by Server::clientsMutex
+    std::chrono::steady_clock::time_point emptySince;
+
+    std::atomic<bool> gameRunning{false};
+    uint64_t tickJob = 0; // TickScheduler job while the game runs
+    // a member asked for the player list; the next tick sends one list
+    // for every request since the last
+    std::atomic<bool> playerListRequested{false};
+    // the last GAME_STATE, written again in place once no connection holds it;
+    // only touched by the lobby's tick
+    std::shared_ptr<std::string> snapshot;
+    std::shared_ptr<LobbyGauges> gauges = std::make_shared<LobbyGauges>(); // shared with metrics scrapes
+
+    Lobby(uint32_t id, uint8_t mapId, GameMode mode)
+      : id(id), game(Game::create(id, mapId, mode)), emptySince(std::chrono::steady_clock::now()) {}
+};
+
+struct LobbyStats {
+    uint32_t lobbyId;
+    size_t players;
+    bool gameRunning;
+    TickStats ticks;
+    MemoryStats gameMemory, snapshotMemory; // zero unless memory accounting is on
+};
+
+struct ClientStats {
+    uint32_t lobbyId;
+    uint32_t playerId;
+    std::string ip;
+    double rttMs;
+    MemoryStats bufferMemory; // zero unless memory accounting is on
+    uint64_t rateLimited;     // messages dropped by the client's rate limits
+};
+
 class Server
 {
 public:
-    Server(unsigned int port = 12345);
+    // new lobbies play mapId (see Map::forId) under the rules of mode,
+    // stepped tickRate times a second
+    Server(unsigned int port = 12345, uint8_t mapId = 0, GameMode mode = MODE_CLASSIC,
+           int tickRate = defaultTicksPerSecond);
     ~Server();
 
     bool init();
     void start(bool inBackground = true);
-    void start_game();
+    bool start_game(uint32_t lobbyId);
     void stop();
+
+    // joins a player through an in-process connection instead of TCP;
+    // returns the client's end
+    std::shared_ptr<Connection> connectLocal();
+
+    uint64_t getMessagesReceived() const { return messagesReceived; }
+    size_t getLobbyCount();
+    // input jitter buffer depth and underrun/overrun counters, by player id
+    std::unordered_map<uint32_t, InputBufferStats> getInputBufferStats(uint32_t lobbyId);
+    // lobby, player id and smoothed round trip time of every connected client
+    std::vector<ClientStats> getClientStats();
+    // roster size and tick counters (including missed deadlines) per lobby
+    std::vector<LobbyStats> getLobbyStats();
+    // closes a connection once it holds more than bytes in its buffers
+    // (see Connection::bufferedBytes); 0 for no cap. Only enforced while
+    // memory accounting is on.
+    void setConnectionMemoryCap(size_t bytes) { connectionMemoryCap = bytes; }
+    // serves /metrics (Prometheus text) and /status (JSON) on 127.0.0.1:port;
+    // scrapes read atomics and a published roster, never the server's locks
+    bool startMetrics(unsigned int metricsPort);
+
+    constexpr static int pingIntervalMs = 1000;
+    constexpr static size_t maxClients = 1024;
+    constexpr static size_t maxPlayersPerLobby = 8;
+    constexpr static int lobbyIdleTimeoutSec = 30;
+    constexpr static int defaultTicksPerSecond = 60;
 private:
-    void gameLoop();
+    friend struct ServerBenchAccess; // bench/game_bench.cpp ticks a lobby on its own thread
+    void tickLobby(Lobby* lobby, uint32_t elapsedMs);
+    void stopLobbyGame(Lobby* lobby);
     void listenForClients();
+    ClientInfo* addClient(std::shared_ptr<Connection> connection, const std::string& ip);
     void cleanFinishedClientThreads();
+    void cleanIdleLobbies();
+    void pingClients();
+    void logMessageRate(std::chrono::steady_clock::time_point& lastTime, uint64_t& lastCount);
+    // trace dumps asked for by signal, and phase timings while profiling
+    void serviceProfiler(std::chrono::steady_clock::time_point& lastLogTime);
+
+    // lobby registry; callers hold clientsMutex
+    Lobby* createLobby();
+    Lobby* findOpenLobby();
+    Lobby* findLobby(uint32_t lobbyId);
+    void joinLobby(ClientInfo* client, Lobby* lobby);
+    void leaveLobby(ClientInfo* client);
+    // moves a client and tells everyone involved; takes clientsMutex
+    void moveClient(ClientInfo* client, uint32_t lobbyId, bool createNew);
+    void sendLobbyWelcome(ClientInfo* client, uint32_t lobbyId, bool isHost);
 
     void stopClient(ClientInfo* client);
     void handleClient(ClientInfo* client);
 
-    void processClientMessage(const std::string& message);
+    void processClientMessage(ClientInfo* client, const std::string& message);
+    // applies the client's rate limits to a message's type; false if it
+    // is to be dropped (and the client, if flooding, has been disconnected)
+    bool admitMessage(ClientInfo* client, const std::string& message);
+    void requestPlayerList(Lobby* lobby);
 
     void broadcastServerShutdown();
-    void broadcastPlayerList();
-    void broadcastGameState();
-    void assignPlayerId(ClientInfo* client);
-    void notifyAll(const char* msg, SOCKET avoid = INVALID_SOCKET);
-    void notifyAllOthers(const char* msg, SOCKET socket);
+    void broadcastPlayerList(uint32_t lobbyId);
+    void broadcastGameState(Lobby* lobby);
+    void notifyAll(const MessagePtr& message, ClientInfo* avoid = nullptr);
+    // scratch holds the list of recipients; ticks pass their tick memory
+    void notifyLobby(uint32_t lobbyId, const MessagePtr& message, ClientInfo* avoid = nullptr,
+                     std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+    // every message to a client goes through here so it is counted
+    bool sendTo(Connection& connection, const MessagePtr& message);
+    // measures the connection while memory accounting is on; closes it and
+    // returns false if it would hold more than the cap with incomingBytes more
+    bool checkConnectionMemory(Connection& connection, size_t incomingBytes = 0);
+
+    // hands scrapes a fresh copy of the clients and lobbies; callers hold clientsMutex
+    void publishRoster();
+    bool serveMetrics(const std::string& path, std::string& body, std::string& contentType);
 
     std::string getClientIP(sockaddr_in* clientAddr);
 
     unsigned int port;
+    uint8_t mapId;
+    GameMode mode;
+    int tickRate;
+    std::atomic<size_t> connectionMemoryCap{0};
     SOCKET serverSocket = INVALID_SOCKET;
 
     std::atomic<bool> serverRunning{false};
-    std::atomic<bool> gameRunning{false};
+    std::atomic<uint64_t> messagesReceived{0};
+    ServerMetrics metrics;
 
     std::thread lobbyThread;
-    std::thread gameThread;
+
+    EventSink eventSink; // logs game events off the tick threads; outlives the ticks
+    // every lobby's game is stepped on this pool; declared before the
+    // scheduler so it outlives it
+    WorkerPool workers;
+    TickScheduler scheduler;
 
     std::mutex clientsMutex;
     std::vector<std::unique_ptr<ClientInfo>> clientThreads;
+    std::unordered_map<uint32_t, std::unique_ptr<Lobby>> lobbies;
+    uint32_t nextLobbyId = 1;
 
-    std::unique_ptr<Game> game;
+    // last, so it stops answering before anything a scrape reads is gone
+    HttpEndpoint metricsEndpoint;
 };
 
 #endif // SERVER_H
@@ -0,0 +1,79 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "../game/worker_pool.h"
+
+struct TickStats {
+    uint64_t ticks = 0;
+    uint64_t missedDeadlines = 0; // ticks finished late or skipped because the last one was still running
+    uint32_t lastLatencyUs = 0;   // deadline to completion of the last tick
+};
+
+// Drives many fixed-rate simulations from one timer thread. At every
+// deadline each registered job is handed to the worker pool, so lobbies
+// tick in parallel instead of each polling on a thread of its own.
+class TickScheduler {
+public:
+    // called on a worker with the milliseconds since the job's last tick
+    using TickFunction = std::function<void(uint32_t elapsedMs)>;
+    // called on a worker after every tick with its deadline-to-completion latency
+    using LatencyObserver = std::function<void(uint32_t latencyUs)>;
+
+    TickScheduler(WorkerPool& pool, std::chrono::microseconds interval);
+    ~TickScheduler();
+
+    void start();
+    void stop(); // waits for ticks in flight
+
+    uint64_t add(TickFunction tick);
+    // once this returns the job's tick function is no longer running;
+    // must not be called from inside that tick function
+    void remove(uint64_t jobId);
+
+    TickStats getStats(uint64_t jobId);
+    size_t getJobCount();
+    // missed deadlines of every job since start, current and removed; lock-free
+    uint64_t getMissedDeadlines() const { return totalMissedDeadlines; }
+    void setLatencyObserver(LatencyObserver observer);
+
+private:
+    struct Job {
+        TickFunction tick;
+        std::atomic<bool> busy{false};    // claimed under jobsMutex until its tick finishes
+        std::atomic<bool> removed{false}; // set under jobsMutex; a claimed tick is then skipped
+        std::chrono::steady_clock::time_point lastTick;
+        std::atomic<uint64_t> ticks{0};
+        std::atomic<uint64_t> missedDeadlines{0};
+        std::atomic<uint32_t> lastLatencyUs{0};
+    };
+
+    void timerLoop();
+    void runJob(Job& job, std::chrono::steady_clock::time_point deadline,
+                const LatencyObserver& observer);
+
+    WorkerPool& pool;
+    const std::chrono::microseconds interval;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> totalMissedDeadlines{0};
+    std::thread timerThread;
+
+    std::mutex jobsMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Job>> jobs;
+    uint64_t nextJobId = 1;
+    LatencyObserver latencyObserver; // guarded by jobsMutex, copied per tick round
+
+    std::mutex idleMutex;
+    std::condition_variable idle; // signalled whenever a job finishes a tick
+};
+
+#endif // TICK_SCHEDULER_H
@@ -0,0 +1,121 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "memory_accounting.h"
+#include "network.h"
+#include "spsc_queue.h"
+
+// Messages are passed around as shared immutable buffers, so a broadcast
+// is serialized once and handed to every connection.
+using MessagePtr = std::shared_ptr<const std::string>;
+
+inline MessagePtr makeMessage(std::string data) {
+    return std::make_shared<const std::string>(std::move(data));
+}
+
+// One end of a message stream between a client and the server.
+class Connection {
+public:
+    virtual ~Connection() = default;
+
+    // safe to call from several threads at once
+    virtual bool send(const MessagePtr& message) = 0;
+    // blocks until the next whole message arrives; nullptr once closed
+    virtual MessagePtr receive() = 0;
+    // wakes up a blocked receive() on both ends
+    virtual void close() = 0;
+
+    // messages handed to send() that the peer has not taken yet
+    virtual size_t pendingSends() const { return 0; }
+    // bytes held for this connection right now: its receive buffer and
+    // the messages handed to send() that the peer has not taken yet
+    virtual size_t bufferedBytes() const { return 0; }
+
+    uint64_t getBytesSent() const { return bytesSent; }
+    uint64_t getBytesReceived() const { return bytesReceived; }
+
+    // bufferedBytes() as last measured, while memory accounting is on
+    MemoryAccount memory{&MemoryAccounting::total(MEMORY_CLIENT_BUFFERS)};
+
+protected:
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> bytesReceived{0};
+};
+
+// Length-framed messages over a TCP socket.
+class TcpConnection : public Connection {
+public:
+    explicit TcpConnection(SOCKET socket);
+    ~TcpConnection() override;
+
+    bool send(const MessagePtr& message) override;
+    MessagePtr receive() override;
+    void close() override;
+    // senders writing or waiting for the socket; grows while the peer's
+    // receive window is full
+    size_t pendingSends() const override { return sendsInFlight; }
+    // includes what the kernel still holds unacknowledged, where it says
+    size_t bufferedBytes() const override {
+        return receiveBufferBytes + sendBytesInFlight + unsentSocketBytes(socket);
+    }
+
+    // an emptied receive buffer larger than this is given back
+    constexpr static size_t shrinkAboveBytes = 64 * 1024;
+
+private:
+    std::atomic<size_t> sendsInFlight{0};
+    std::atomic<size_t> sendBytesInFlight{0};
+    std::atomic<size_t> receiveBufferBytes{0}; // receiveBuffer.capacity(), readable from any thread
+    std::mutex sendMutex;
+    // the descriptor is only released by the destructor, once no sender can
+    // hold it; close() just shuts it down, so a concurrent send fails instead
+    // of writing to a descriptor that accept() has handed to another client
+    const SOCKET socket;
+    std::atomic<bool> closed{false};
+    std::string receiveBuffer; // receiving thread only
+};
+
+// Direction of a LocalConnection pair: a lock-free SPSC ring of shared
+// buffers. Senders are serialized by a mutex so the ring only ever sees
+// one producer; the receiver only sleeps when the ring is empty.
+struct LocalChannel {
+    SpscQueue<MessagePtr> queue{4096};
+    std::mutex sendMutex;
+    std::mutex waitMutex;
+    std::condition_variable ready;
+    std::atomic<bool> receiverWaiting{false};
+    std::atomic<bool> closed{false};
+    std::atomic<size_t> queuedBytes{0}; // payload bytes in queue
+};
+
+// In-process connection used when the hosting player joins their own
+// server: no framing, no sockets, no copies of the message buffers.
+class LocalConnection : public Connection {
+public:
+    LocalConnection(std::shared_ptr<LocalChannel> in, std::shared_ptr<LocalChannel> out)
+      : inbound(std::move(in)), outbound(std::move(out)) {}
+    ~LocalConnection() override { close(); }
+
+    bool send(const MessagePtr& message) override;
+    MessagePtr receive() override;
+    void close() override;
+    size_t pendingSends() const override { return outbound->queue.size(); }
+    // the messages share their buffers with every other connection, so
+    // this overstates what the process holds for this one
+    size_t bufferedBytes() const override { return outbound->queuedBytes; }
+
+private:
+    std::shared_ptr<LocalChannel> inbound, outbound;
+};
+
+// returns both ends of a new in-process connection
+std::pair<std::shared_ptr<Connection>, std::shared_ptr<Connection>> makeLocalConnectionPair();
+
+#endif // TRANSPORT_H
@@ -2,4 +2,5 @@
 cmake -DCMAKE_EXPORT_COMPILE_COMMANDS=ON -B build && \
 cmake --build build && \
 mkdir -p bin/linux && \
-cp build/TagPro bin/linux
+cp build/tagpro_server bin/linux && \
+{ [ ! -f build/TagPro ] || cp build/TagPro bin/linux; }
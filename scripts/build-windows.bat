@@ -5,4 +5,5 @@ if not exist bin\windows (
     mkdir bin\windows
 )
 
-copy build\TagPro.exe bin\windows\
+copy build\tagpro_server.exe bin\windows\
+if exist build\TagPro.exe copy build\TagPro.exe bin\windows\
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Convert a text map into the binary .tpmap format loaded by the game.
+
+One character per tile, one line per row:
+  #  wall          .  open floor
+  R  red flag      B  blue flag
+  r  red spawn     b  blue spawn
+Flags and spawns sit on open floor at the centre of their tile.
+
+usage: scripts/make-map.py maps/1.txt maps/1.tpmap [tile size in px, default 40]
+"""
+import struct
+import sys
+
+MAGIC = b"TPMP"
+VERSION = 1
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    source, target = sys.argv[1], sys.argv[2]
+    tile_size = int(sys.argv[3]) if len(sys.argv) > 3 else 40
+
+    rows = [line.rstrip("\n") for line in open(source) if line.strip()]
+    width, height = max(len(row) for row in rows), len(rows)
+    tiles = bytearray()
+    marks = {}
+    for y, row in enumerate(rows):
+        for x, char in enumerate(row.ljust(width, ".")):
+            tiles.append(1 if char == "#" else 0)
+            if char in "RBrb":
+                marks[char] = ((x + 0.5) * tile_size, (y + 0.5) * tile_size)
+
+    missing = [char for char in "RBrb" if char not in marks]
+    if missing:
+        sys.exit("map is missing: " + " ".join(missing))
+
+    header = struct.pack("<4sHHHH8f", MAGIC, VERSION, tile_size, width, height,
+                         *marks["R"], *marks["B"], *marks["r"], *marks["b"])
+    with open(target, "wb") as out:
+        out.write(header + tiles)
+    print(f"{target}: {width}x{height} tiles of {tile_size} px")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+#include "game/bot.h"
+
+#include <cmath>
+
+Bot::Bot(uint32_t playerId, uint32_t seed) : playerId(playerId), rng(seed) {}
+
+void Bot::think(const GameState& state, float& inputX, float& inputY) {
+    inputX = inputY = 0;
+    auto it = state.players.find(playerId);
+    if (it == state.players.end()) return;
+    const PlayerState& self = it->second;
+
+    // head home with the flag, otherwise for the enemy flag
+    uint8_t side = (self.team == REDTEAM) == self.hasFlag ? REDTEAM : BLUETEAM;
+    if (!map || mapId != state.mapId) {
+        mapId = state.mapId;
+        map = Map::forId(mapId);
+    }
+    float targetX = map->getFlagX(side);
+    float targetY = map->getFlagY(side);
+
+    if (ticksUntilWeave == 0) {
+        std::uniform_real_distribution<float> offset(-0.6f, 0.6f);
+        std::uniform_int_distribution<uint32_t> hold(20, 60);
+        weaveX = offset(rng);
+        weaveY = offset(rng);
+        ticksUntilWeave = hold(rng);
+    }
+    --ticksUntilWeave;
+
+    float dx = targetX - self.x;
+    float dy = targetY - self.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length > 0) {
+        inputX = dx / length + weaveX;
+        inputY = dy / length + weaveY;
+    }
+}
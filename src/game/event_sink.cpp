@@ -0,0 +1,73 @@
+#include "game/event_sink.h"
+
+#include "game/game_state.h"
+#include "network/logger.h"
+
+#define GAME_LOG(fmt, ...) LOG("[GAME] " fmt, ##__VA_ARGS__)
+
+EventSink::EventSink(Consumer consumer) : consumer(std::move(consumer)) {
+    thread = std::thread(&EventSink::run, this);
+}
+
+EventSink::~EventSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_one();
+    thread.join();
+}
+
+void EventSink::submit(uint32_t lobbyId, const std::vector<GameEvent>& events) {
+    if (events.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const GameEvent& event : events) {
+            if (pending.size() >= maxPending) {
+                dropped += 1;
+                continue;
+            }
+            pending.push_back({lobbyId, event});
+        }
+    }
+    ready.notify_one();
+}
+
+void EventSink::run() {
+    std::vector<Entry> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) return; // stopping, and everything delivered
+        // swap so submitters never wait on the consumer
+        batch.swap(pending);
+        lock.unlock();
+        for (const Entry& entry : batch) {
+            consumer(entry.lobbyId, entry.event);
+        }
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void EventSink::logEvent(uint32_t lobbyId, const GameEvent& event) {
+    const char* team = event.team == REDTEAM ? "red" : "blue";
+    switch (event.kind) {
+    case EVENT_FLAG_TAKEN:
+        GAME_LOG("Lobby %u tick %u: player %u (%s) took the flag at (%.0f, %.0f)",
+                 lobbyId, event.tick, event.playerId, team, event.x, event.y);
+        break;
+    case EVENT_CAPTURE:
+        GAME_LOG("Lobby %u tick %u: player %u scored for the %s team",
+                 lobbyId, event.tick, event.playerId, team);
+        break;
+    case EVENT_POP:
+        GAME_LOG("Lobby %u tick %u: player %u (%s) was popped by player %u at (%.0f, %.0f)",
+                 lobbyId, event.tick, event.playerId, team, event.otherId, event.x, event.y);
+        break;
+    case EVENT_RESPAWN:
+        GAME_LOG("Lobby %u tick %u: player %u (%s) respawned",
+                 lobbyId, event.tick, event.playerId, team);
+        break;
+    }
+}
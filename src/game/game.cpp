@@ -1,33 +1,84 @@
 #include "game/game.h"
 
-#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include "game/game_state.h"
+#include "game/map.h"
+#include "game/timing_wheel.h"
+#include "game/worker_pool.h"
+#include "network/logger.h"
+#include "network/profiler.h"
+
+#define GAME_LOG(fmt, ...) LOG("[GAME] " fmt, ##__VA_ARGS__)
+
+namespace {
+// Earliest fraction t of the step at which a point starting at (x, y) and
+// moving by (dx, dy) comes within `radius` of the origin. Starting inside
+// counts as t = 0.
+bool timeOfImpact(float x, float y, float dx, float dy, float radius, float& t) {
+    float c = x * x + y * y - radius * radius;
+    if (c <= 0) {
+        t = 0;
+        return true;
+    }
+    float a = dx * dx + dy * dy;
+    float b = x * dx + y * dy;
+    if (a == 0 || b >= 0) return false; // not closing in
+    float discriminant = b * b - a * c;
+    if (discriminant < 0) return false;
+    t = (-b - std::sqrt(discriminant)) / a;
+    return t <= 1;
+}
+}
 
-#define GAME_LOG(fmt, ...) \
-  { qInfo().noquote() << "[GAME] " << QString().asprintf(fmt, ##__VA_ARGS__); }
+std::unique_ptr<Game> Game::create(uint32_t lobbyId, uint8_t mapId, GameMode mode) {
+    switch (mode) {
+    case MODE_NO_FRICTION:
+        return std::make_unique<RulesGame<NoFrictionRules>>(lobbyId, mapId, mode);
+    case MODE_SINGLE_FLAG:
+        return std::make_unique<RulesGame<SingleFlagRules>>(lobbyId, mapId, mode);
+    default:
+        if (mode != MODE_CLASSIC) GAME_LOG("Unknown game mode %d, playing classic", mode);
+        return std::make_unique<RulesGame<ClassicRules>>(lobbyId, mapId, MODE_CLASSIC);
+    }
+}
 
-Game::Game(uint32_t lobbyId) {
+Game::Game(uint32_t lobbyId, uint8_t mapId, GameMode mode) : map(Map::forId(mapId)), mode(mode) {
   currentState.lobbyId = lobbyId;
-  currentState.mapId = 0;
+  currentState.mapId = mapId;
   currentState.redScore = 0;
   currentState.blueScore = 0;
+  tickEvents.reserve(expectedEventsPerTick);
 }
 void Game::start() {
     GAME_LOG("Started lobby %d", currentState.lobbyId);
-    currentState.mapId = currentState.redScore = currentState.blueScore = 0;
+    currentState.redScore = currentState.blueScore = 0;
     currentState.redFlag = currentState.blueFlag = 0;
+    currentState.tick = 0;
+    inputBuffers.clear();
+    for (const auto& [id, player] : currentState.players) {
+        inputBuffers[id]; // made here, not on the first input, to keep the tick off the heap
+    }
+    tickEvents.clear();
+    timers.clear();
+    respawnTimers.clear();
+    for (auto& [id, player] : currentState.players) {
+        player.respawnTimer = 0;
+    }
 }
 
 void Game::stop() {
     GAME_LOG("Stopped lobby %d", currentState.lobbyId);
 }
 
-float Game::getTeamSpawnXLocation(uint8_t team) {
-    if (team == 0) {
-        return 100.0f;
-    } else {
-        return arenaWidth - 100.0f;
-    }
+void Game::moveToSpawn(PlayerState& player) {
+    player.x = player.prevX = player.contactX = map->getSpawnX(player.team);
+    player.y = player.prevY = player.contactY = map->getSpawnY(player.team);
+}
+
+void Game::recordEvent(GameEventKind kind, const PlayerState& player, uint32_t otherId) {
+    tickEvents.push_back({currentState.tick, kind, player.team, player.id, otherId, player.x, player.y});
 }
 
 uint32_t Game::addPlayer(const std::string& name, uint8_t team) {
@@ -36,10 +87,10 @@ uint32_t Game::addPlayer(const std::string& name, uint8_t team) {
 
     PlayerState player(playerId, name, team);
 
-    player.x = getTeamSpawnXLocation(team);
-    player.y = arenaHeight / 2.0f;
+    moveToSpawn(player);
 
     currentState.players[playerId] = player;
+    inputBuffers[playerId];
     GAME_LOG("%s (id: %d) added to team %d", name.c_str(), playerId, team);
     return playerId;
 }
@@ -48,6 +99,12 @@ bool Game::removePlayer(uint32_t playerId) {
     std::lock_guard<std::mutex> lock(stateMutex);
     GAME_LOG("%s removed from game", currentState.players[playerId].name.c_str());
     bool res = currentState.players.erase(playerId) > 0;
+    inputBuffers.erase(playerId);
+    auto respawn = respawnTimers.find(playerId);
+    if (respawn != respawnTimers.end()) {
+        timers.cancel(respawn->second);
+        respawnTimers.erase(respawn);
+    }
     if (res && currentState.players.empty()) {
       // restart score
       currentState.redScore = currentState.blueScore = 0;
@@ -56,22 +113,16 @@ bool Game::removePlayer(uint32_t playerId) {
     return res;
 }
 
-void Game::pop(PlayerState& player) {
-    player.hasFlag = false;
-    player.velocityX = 0;
-    player.velocityY = 0;
-    player.x = getTeamSpawnXLocation(player.team);
-    player.y = arenaHeight / 2.0f;
-    if (player.team == REDTEAM) {
-        currentState.blueFlag = 0;
-    } else {
-        currentState.redFlag = 0;
-    }
+void Game::queuePlayerInput(uint32_t playerId, float inputX, float inputY, uint32_t sequence, uint32_t clientTick) {
+    std::lock_guard<std::mutex> lock(inputQueueMutex);
+    inputQueue.push({playerId, inputX, inputY, sequence, clientTick});
+    inputQueueDepth.store(inputQueue.size(), std::memory_order_relaxed);
 }
 
-void Game::queuePlayerInput(uint32_t playerId, float inputX, float inputY) {
-    std::lock_guard<std::mutex> lock(inputQueueMutex);
-    inputQueue.push({playerId, inputX, inputY});
+void Game::setWorkerPool(WorkerPool* pool, size_t threshold) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    workerPool = pool;
+    parallelCollisionThreshold = threshold;
 }
 
 // unused
@@ -84,6 +135,11 @@ bool Game::setPlayerTeam(uint32_t playerId, uint8_t team) {
     return false;
 }
 
+GameState Game::getGameState() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return currentState;
+}
+
 PlayerState* Game::getPlayerState(uint32_t playerId) {
     // caller locks
     return currentState.getPlayer(playerId);
@@ -98,59 +154,157 @@ int32_t Game::getNextPlayerId() const {
   return next;
 }
 
+std::unordered_map<uint32_t, InputBufferStats> Game::getInputBufferStats() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    std::unordered_map<uint32_t, InputBufferStats> stats;
+    for (const auto& [id, buffer] : inputBuffers) {
+        stats[id] = buffer.getStats();
+    }
+    return stats;
+}
+
+namespace {
+// buckets plus one node per element; a node holds the next pointer, the
+// element and (for these integer keys) nothing else
+template <typename HashMap>
+size_t hashMapBytes(const HashMap& map) {
+    return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(void*) + sizeof(typename HashMap::value_type));
+}
+
+size_t stringHeapBytes(const std::string& text) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+}
+
+size_t Game::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    size_t bytes = hashMapBytes(currentState.players) + hashMapBytes(inputBuffers) + hashMapBytes(respawnTimers);
+    for (const auto& [id, player] : currentState.players) bytes += stringHeapBytes(player.name);
+    bytes += inputQueueDepth.load(std::memory_order_relaxed) * sizeof(PlayerInput);
+    bytes += timers.getMemoryUsage();
+    bytes += tickEvents.capacity() * sizeof(GameEvent);
+    bytes += tickArena.capacity();
+    return bytes;
+}
+
 void Game::update(uint32_t deltaTimeMs) {
+    auto start = std::chrono::steady_clock::now();
     float deltaTimeSec = deltaTimeMs / 1000.0f;
-    for (auto& pair : currentState.players) {
-        PlayerState& player = pair.second;
-
-        if (player.respawnTimer > 0) {
-            player.respawnTimer -= std::min(player.respawnTimer, deltaTimeMs);
-        }
+    std::lock_guard<std::mutex> lock(stateMutex);
+    uint32_t tick = ++currentState.tick;
+    tickEvents.clear();
+    tickArena.reset();
+    {
+        // respawns and other rule timers that come due during this step
+        PROFILE_ZONE("timers");
+        timers.advance(timers.getTime() + deltaTimeMs);
     }
     {
+        PROFILE_ZONE("input drain");
         std::lock_guard<std::mutex> lock(inputQueueMutex);
         while (!inputQueue.empty()) {
             const auto& input = inputQueue.front();
-            if (auto* player = currentState.getPlayer(input.playerId)) {
-                if (player->respawnTimer != 0) {
-                    continue;
-                }
-                updatePlayerVelocity(*player, input.inputX, input.inputY, deltaTimeSec);
+            if (currentState.getPlayer(input.playerId)) {
+                inputBuffers[input.playerId].push(input, tick);
             }
             inputQueue.pop();
         }
+        inputQueueDepth.store(0, std::memory_order_relaxed);
     }
 
-    std::lock_guard<std::mutex> lock(stateMutex);
-    for (auto& [id, player] : currentState.players) {
-        if (!player.connected) continue;
-        applyPhysics(player, deltaTimeSec);
-        checkBoundaries(player);
+    // clients only send when their input changes (plus a slow heartbeat),
+    // so the latest input is held on the player and applied every tick
+    for (auto& [id, buffer] : inputBuffers) {
+        PlayerInput input;
+        if (buffer.pop(tick, input)) {
+            PlayerState& player = currentState.players[id];
+            player.inputX = input.inputX;
+            player.inputY = input.inputY;
+            player.lastInputSeq = input.sequence;
+        }
+    }
+
+    step(deltaTimeSec);
+    // sent with the state, so the broadcast serializes it without a copy
+    currentState.tickDurationUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename Rules>
+RulesGame<Rules>::RulesGame(uint32_t lobbyId, uint8_t mapId, GameMode mode, Rules rules)
+    : Game(lobbyId, mapId, mode), rules(rules) {}
+
+template <typename Rules>
+void RulesGame<Rules>::step(float deltaTimeSec) {
+    {
+        PROFILE_ZONE("physics");
+        for (auto& [id, player] : currentState.players) {
+            if (!player.connected) continue;
+            if (player.respawnTimer == 0) {
+                updatePlayerVelocity(player, player.inputX, player.inputY, deltaTimeSec);
+            }
+            player.prevX = player.contactX = player.x;
+            player.prevY = player.contactY = player.y;
+            applyPhysics(player, deltaTimeSec);
+            checkBoundaries(player, player.prevX, player.prevY, deltaTimeSec);
+        }
+    }
+    resolveCollisions(deltaTimeSec);
+}
+template <typename Rules>
+void RulesGame<Rules>::pop(PlayerState& player, uint32_t taggerId) {
+    recordEvent(EVENT_POP, player, taggerId);
+    player.hasFlag = false;
+    player.velocityX = 0;
+    player.velocityY = 0;
+    moveToSpawn(player);
+    if (player.team == REDTEAM) {
+        currentState.blueFlag = 0;
+    } else {
+        currentState.redFlag = 0;
     }
-    resolveCollisions();
+
+    if (rules.respawnDelayMs == 0) return;
+    // out of play at the base until the timer brings them back
+    uint32_t playerId = player.id;
+    player.respawnTimer = rules.respawnDelayMs;
+    respawnTimers[playerId] = timers.schedule(rules.respawnDelayMs, [this, playerId] {
+        respawnTimers.erase(playerId);
+        if (PlayerState* respawned = currentState.getPlayer(playerId)) {
+            respawned->respawnTimer = 0;
+            recordEvent(EVENT_RESPAWN, *respawned);
+        }
+    });
 }
 
-void Game::updatePlayerVelocity(PlayerState& player, float inputX, float inputY, float deltaTimeSec) {
+
+template <typename Rules>
+void RulesGame<Rules>::updatePlayerVelocity(PlayerState& player, float inputX, float inputY, float deltaTimeSec) {
     float length = std::sqrt(inputX * inputX + inputY * inputY);
     if (length > 1.0f) {
       inputX /= length;
       inputY /= length;
     }
 
-    player.velocityX += inputX * playerAcceleration * deltaTimeSec;
-    player.velocityY += inputY * playerAcceleration * deltaTimeSec;
+    player.velocityX += inputX * rules.playerAcceleration * deltaTimeSec;
+    player.velocityY += inputY * rules.playerAcceleration * deltaTimeSec;
 
     float speed = std::sqrt(player.velocityX * player.velocityX +
                             player.velocityY * player.velocityY);
-    if (speed > playerMaxSpeed) {
-        player.velocityX = (player.velocityX / speed) * playerMaxSpeed;
-        player.velocityY = (player.velocityY / speed) * playerMaxSpeed;
+    if (speed > rules.playerMaxSpeed) {
+        player.velocityX = (player.velocityX / speed) * rules.playerMaxSpeed;
+        player.velocityY = (player.velocityY / speed) * rules.playerMaxSpeed;
     }
 }
 
-void Game::applyPhysics(PlayerState& player, float deltaTimeSec) {
-    player.velocityX *= std::pow(playerFriction, deltaTimeSec);
-    player.velocityY *= std::pow(playerFriction, deltaTimeSec);
+template <typename Rules>
+void RulesGame<Rules>::applyPhysics(PlayerState& player, float deltaTimeSec) {
+    if (rules.playerFriction < 1.0f) {
+        float kept = std::pow(rules.playerFriction, deltaTimeSec);
+        player.velocityX *= kept;
+        player.velocityY *= kept;
+    }
 
     player.x += player.velocityX * deltaTimeSec;
     player.y += player.velocityY * deltaTimeSec;
@@ -159,91 +313,245 @@ void Game::applyPhysics(PlayerState& player, float deltaTimeSec) {
     if (std::abs(player.velocityY) < 0.01f) player.velocityY = 0;
 }
 
-void Game::checkBoundaries(PlayerState& player) {
-    // Left Wall
-    if (player.x < playerRadius) {
-        player.x = playerRadius;
-
-        if (player.velocityX < 0) {
-            player.velocityX = -player.velocityX * wallRestitution;
+template <typename Rules>
+void RulesGame<Rules>::checkBoundaries(PlayerState& player, float fromX, float fromY, float deltaTimeSec) {
+    // the end of a long step (a low tick rate, or a late tick) can lie past
+    // a thin wall, so the path is walked in strides short enough that it
+    // cannot skip one. At the first point in reach of a wall the player
+    // bounces and spends the rest of the step on the new velocity.
+    const float stride = std::min(map->getTileSize() * 0.5f, playerRadius);
+    for (int contact = 0; contact < maxWallContactsPerStep; ++contact) {
+        float dx = player.x - fromX;
+        float dy = player.y - fromY;
+        int strides = static_cast<int>(std::ceil(std::sqrt(dx * dx + dy * dy) / stride));
+        int hit = 1;
+        float nx, ny;
+        while (hit < strides && map->distanceToWall(fromX + dx * hit / strides, fromY + dy * hit / strides,
+                                                    nx, ny) >= playerRadius) {
+            ++hit;
         }
-    } 
-    // Right Wall
-    else if (player.x > arenaWidth - playerRadius) {
-        player.x = arenaWidth - playerRadius;
+        if (hit >= strides) break;
+
+        float t = float(hit) / strides;
+        player.x = player.contactX = fromX + dx * t;
+        player.y = player.contactY = fromY + dy * t;
+        pushOutOfWalls(player);
+        fromX = player.x;
+        fromY = player.y;
+        deltaTimeSec *= 1 - t;
+        player.x += player.velocityX * deltaTimeSec;
+        player.y += player.velocityY * deltaTimeSec;
+    }
+    pushOutOfWalls(player);
+}
 
-        if (player.velocityX > 0) {
-            player.velocityX = -player.velocityX * wallRestitution;
+template <typename Rules>
+void RulesGame<Rules>::pushOutOfWalls(PlayerState& player) {
+    // the map's distance field gives the nearest wall and its normal in
+    // constant time. A player that reaches a wall bounces there, the
+    // overshoot turned back at the reduced speed. A second pass settles
+    // corners, where two walls are in reach.
+    for (int pass = 0; pass < 2; ++pass) {
+        float nx, ny;
+        float distance = map->distanceToWall(player.x, player.y, nx, ny);
+        if (distance >= playerRadius) return;
+
+        float overshoot = playerRadius - distance;
+        player.x += nx * overshoot * (1 + rules.wallRestitution);
+        player.y += ny * overshoot * (1 + rules.wallRestitution);
+
+        float velAlongNormal = player.velocityX * nx + player.velocityY * ny;
+        if (velAlongNormal < 0) {
+            player.velocityX -= (1 + rules.wallRestitution) * velAlongNormal * nx;
+            player.velocityY -= (1 + rules.wallRestitution) * velAlongNormal * ny;
         }
     }
+}
 
-    // Top Wall
-    if (player.y < playerRadius) {
-        player.y = playerRadius;
+template <typename Rules>
+void RulesGame<Rules>::resolveCollisions(float deltaTimeSec) {
+  // players in id order so every run, serial or parallel, sees the same order
+  std::pmr::vector<PlayerState*> active(tickArena.resource());
+  active.reserve(currentState.players.size());
+  for (auto& [id, player] : currentState.players) {
+    if (player.respawnTimer == 0) active.push_back(&player);
+  }
+  std::sort(active.begin(), active.end(),
+            [](const PlayerState* a, const PlayerState* b) { return a->id < b->id; });
+
+  // islands share no players, so they can be resolved in any order or at
+  // once; pops touch the flags and wait until every island is done
+  std::pmr::vector<std::pmr::vector<PlayerState*>> islands(tickArena.resource());
+  {
+    PROFILE_ZONE("islands");
+    islands = buildCollisionIslands(active);
+  }
+  // a pop's tag is rare and may be recorded on any worker, so tags use the
+  // thread-safe heap rather than the arena
+  std::pmr::vector<std::vector<Tag>> tags(islands.size(), tickArena.resource());
+  {
+    PROFILE_ZONE("collisions");
+    auto resolve = [&](size_t i) { resolveIsland(islands[i], deltaTimeSec, tags[i]); };
+    if (workerPool && active.size() >= parallelCollisionThreshold && islands.size() > 1) {
+      workerPool->parallelFor(islands.size(), resolve);
+    } else {
+      for (size_t i = 0; i < islands.size(); ++i) resolve(i);
+    }
+  }
 
-        if (player.velocityY < 0) {
-            player.velocityY = -player.velocityY * wallRestitution;
-        }
-    } 
-    // Bottom Wall
-    else if (player.y > arenaHeight - playerRadius) {
-        player.y = arenaHeight - playerRadius;
+  {
+    // after the bounces, so a player turned back short of a flag does not
+    // reach it; before the pops, which send carriers home
+    PROFILE_ZONE("flags");
+    for (PlayerState* player : active) {
+      updateFlags(*player);
+    }
+  }
 
-        if (player.velocityY > 0) {
-            player.velocityY = -player.velocityY * wallRestitution;
-        }
+  PROFILE_ZONE("pops");
+  for (auto& islandTags : tags) {
+    for (const Tag& tag : islandTags) {
+      if (!tag.carrier->hasFlag) continue; // tagged twice this tick
+      pop(*tag.carrier, tag.taggerId);
     }
+  }
 }
 
-void Game::resolveCollisions() {
-
-  std::vector<uint32_t> playerIds;
-  for (const std::pair<uint32_t, PlayerState>& pair : currentState.players) {
-    playerIds.push_back(pair.first);
-  }
-  for (int i = 0; i < playerIds.size(); ++i) {
-    PlayerState* player1 = getPlayerState(playerIds[i]);
-    if (!player1) continue;
-    if (player1->respawnTimer != 0) continue;
-
-    if (player1->team == REDTEAM && currentState.blueFlag == 0) {
-        if (checkCollision(player1->x, player1->y, blueFlagX, blueFlagY)) {
-            player1->hasFlag = true;
-            currentState.blueFlag = player1->id;
-            GAME_LOG("%s:%d has picked up the flag!", player1->name.c_str(), player1->id);
+template <typename Rules>
+void RulesGame<Rules>::updateFlags(PlayerState& player) {
+    if (player.team == REDTEAM && currentState.blueFlag == 0) {
+        if (sweptTouches(player, map->getFlagX(BLUETEAM), map->getFlagY(BLUETEAM))) {
+            player.hasFlag = true;
+            currentState.blueFlag = player.id;
+            recordEvent(EVENT_FLAG_TAKEN, player);
         }
-    } else if (player1->team == BLUETEAM && currentState.redFlag == 0) {
-        if (checkCollision(player1->x, player1->y, redFlagX, redFlagY)) {
-            player1->hasFlag = true;
-            currentState.redFlag = player1->id;
-            GAME_LOG("%s:%d has picked up the red flag!", player1->name.c_str(), player1->id);
+    } else if (rules.redFlagInPlay && player.team == BLUETEAM && currentState.redFlag == 0) {
+        if (sweptTouches(player, map->getFlagX(REDTEAM), map->getFlagY(REDTEAM))) {
+            player.hasFlag = true;
+            currentState.redFlag = player.id;
+            recordEvent(EVENT_FLAG_TAKEN, player);
         }
     }
 
-    if (player1->hasFlag) {
-        if (player1->team == REDTEAM && currentState.redFlag == 0) {
-            if (checkCollision(player1->x, player1->y, redFlagX, redFlagY)) {
-                player1->hasFlag = false;
+    if (player.hasFlag) {
+        if (player.team == REDTEAM && currentState.redFlag == 0) {
+            if (sweptTouches(player, map->getFlagX(REDTEAM), map->getFlagY(REDTEAM))) {
+                player.hasFlag = false;
                 currentState.blueFlag = 0;
                 currentState.redScore++;
-                GAME_LOG("%s:%d has scored for the red team!", player1->name.c_str(), player1->id);
+                recordEvent(EVENT_CAPTURE, player);
             }
-        } else if (player1->team == BLUETEAM && currentState.blueFlag == 0) {
-            if (checkCollision(player1->x, player1->y, blueFlagX, blueFlagY)) {
-                player1->hasFlag = false;
+        } else if (player.team == BLUETEAM && currentState.blueFlag == 0) {
+            if (sweptTouches(player, map->getFlagX(BLUETEAM), map->getFlagY(BLUETEAM))) {
+                player.hasFlag = false;
                 currentState.redFlag = 0;
                 currentState.blueScore++;
-                GAME_LOG("%s:%d has scored for the blue team!", player1->name.c_str(), player1->id);
+                recordEvent(EVENT_CAPTURE, player);
             }
         }
     }
+}
 
-    for (int j = i + 1; j < playerIds.size(); ++j) {
-      PlayerState* player2 = getPlayerState(playerIds[j]);
-      if (!player2) continue;
-      if (player2->respawnTimer != 0) continue;
+std::pmr::vector<std::pmr::vector<PlayerState*>> Game::buildCollisionIslands(const std::pmr::vector<PlayerState*>& players) {
+    // union-find over players that come within reach of each other during
+    // the step. Players are entered into every cell within half a reach of
+    // their path, so any two that get within reach share a cell.
+    const float reach = playerRadius * 2 + collisionIslandMargin;
+    std::pmr::memory_resource* scratch = tickArena.resource();
+    std::pmr::vector<size_t> parent(players.size(), scratch);
+    for (size_t i = 0; i < parent.size(); ++i) parent[i] = i;
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    auto cellKey = [](int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(cx) << 32) ^ static_cast<uint32_t>(cy);
+    };
+    auto cellOf = [reach](float v) { return static_cast<int64_t>(std::floor(v / reach)); };
+    std::pmr::unordered_map<uint64_t, std::pmr::vector<size_t>> cells(scratch);
+    cells.reserve(players.size() * 2);
+    for (size_t i = 0; i < players.size(); ++i) {
+        // every cell within half a reach of the player's path this step
+        const PlayerState& p = *players[i];
+        const float half = reach / 2;
+        for (int64_t cx = cellOf(std::min(p.prevX, p.x) - half); cx <= cellOf(std::max(p.prevX, p.x) + half); ++cx) {
+            for (int64_t cy = cellOf(std::min(p.prevY, p.y) - half); cy <= cellOf(std::max(p.prevY, p.y) + half); ++cy) {
+                cells[cellKey(cx, cy)].push_back(i);
+            }
+        }
+    }
+    for (auto& [key, members] : cells) {
+        (void)key;
+        for (size_t a = 0; a < members.size(); ++a) {
+            for (size_t b = a + 1; b < members.size(); ++b) {
+                size_t i = members[a], j = members[b];
+                if (find(i) == find(j)) continue;
+                const PlayerState& p1 = *players[i];
+                const PlayerState& p2 = *players[j];
+                float t;
+                if (timeOfImpact(p1.prevX - p2.prevX, p1.prevY - p2.prevY,
+                                 (p1.x - p1.prevX) - (p2.x - p2.prevX),
+                                 (p1.y - p1.prevY) - (p2.y - p2.prevY), reach, t)) {
+                    parent[find(i)] = find(j);
+                }
+            }
+        }
+    }
 
-      if (checkCollision(player1->x, player1->y, player2->x, player2->y)) {
+    // islands ordered by their lowest id, members in id order
+    std::pmr::vector<std::pmr::vector<PlayerState*>> islands(scratch);
+    std::pmr::unordered_map<size_t, size_t> islandOfRoot(scratch);
+    islandOfRoot.reserve(players.size());
+    for (size_t i = 0; i < players.size(); ++i) {
+        auto [it, inserted] = islandOfRoot.emplace(find(i), islands.size());
+        if (inserted) islands.emplace_back();
+        islands[it->second].push_back(players[i]);
+    }
+    islands.erase(std::remove_if(islands.begin(), islands.end(),
+                                 [](const auto& island) { return island.size() < 2; }),
+                  islands.end());
+    return islands;
+}
+
+template <typename Rules>
+void RulesGame<Rules>::resolveIsland(const std::pmr::vector<PlayerState*>& island, float deltaTimeSec,
+                         std::vector<Tag>& tags) {
+  for (size_t i = 0; i < island.size(); ++i) {
+    PlayerState* player1 = island[i];
+    for (size_t j = i + 1; j < island.size(); ++j) {
+      PlayerState* player2 = island[j];
+
+      // players that were apart when the step began meet where their
+      // paths first touch, whatever the tick rate; only those already in
+      // contact are pushed apart from where they ended up
+      float rx = player1->prevX - player2->prevX;
+      float ry = player1->prevY - player2->prevY;
+      float t;
+      if (rx * rx + ry * ry >= playerRadius * playerRadius * 4 &&
+          timeOfImpact(rx, ry,
+                       (player1->x - player1->prevX) - (player2->x - player2->prevX),
+                       (player1->y - player1->prevY) - (player2->y - player2->prevY),
+                       playerRadius * 2, t)) {
+        // rewind both to the moment they touched, bounce, then spend the
+        // rest of the step on the new velocities
+        for (PlayerState* player : {player1, player2}) {
+          player->x = player->contactX = player->prevX + (player->x - player->prevX) * t;
+          player->y = player->contactY = player->prevY + (player->y - player->prevY) * t;
+        }
+        float dx = player1->x - player2->x;
+        float dy = player1->y - player2->y;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        bounce(*player1, *player2, dx / distance, dy / distance, tags);
+
+        float remainingSec = (1 - t) * deltaTimeSec;
+        for (PlayerState* player : {player1, player2}) {
+          float contactX = player->x, contactY = player->y;
+          player->x += player->velocityX * remainingSec;
+          player->y += player->velocityY * remainingSec;
+          checkBoundaries(*player, contactX, contactY, remainingSec);
+        }
+      } else if (checkCollision(player1->x, player1->y, player2->x, player2->y)) {
         float dx = player1->x - player2->x;
         float dy = player1->y - player2->y;
         float distance = std::sqrt(dx * dx + dy * dy);
@@ -258,36 +566,53 @@ void Game::resolveCollisions() {
         player2->x -= nx * separation;
         player2->y -= ny * separation;
 
-        float rvx = player1->velocityX - player2->velocityX;
-        float rvy = player1->velocityY - player2->velocityY;
+        bounce(*player1, *player2, nx, ny, tags);
+      }
+    }
+  }
+}
 
-        float velAlongNormal = rvx * nx + rvy * ny;
+template <typename Rules>
+void RulesGame<Rules>::bounce(PlayerState& player1, PlayerState& player2, float nx, float ny,
+                  std::vector<Tag>& tags) {
+    float rvx = player1.velocityX - player2.velocityX;
+    float rvy = player1.velocityY - player2.velocityY;
 
-        if (velAlongNormal > 0.0f)
-          continue;
+    float velAlongNormal = rvx * nx + rvy * ny;
 
-        float jImpulse = -(1.0f + playerRestitution) * velAlongNormal;
-        jImpulse /= 2.0f;
+    if (velAlongNormal > 0.0f)
+      return;
 
-        float impulseX = nx * jImpulse;
-        float impulseY = ny * jImpulse;
+    float jImpulse = -(1.0f + rules.playerRestitution) * velAlongNormal;
+    jImpulse /= 2.0f;
 
-        player1->velocityX += impulseX;
-        player1->velocityY += impulseY;
+    float impulseX = nx * jImpulse;
+    float impulseY = ny * jImpulse;
 
-        player2->velocityX -= impulseX;
-        player2->velocityY -= impulseY;
-        if (player2->hasFlag && player1->team != player2->team) {
-            pop(*player2);
-            GAME_LOG("%s was popped", player2->name.c_str());
-        }
-        if (player1->hasFlag && player1->team != player2->team) {
-            pop(*player1);
-            GAME_LOG("%s was popped", player1->name.c_str());
-        }
-      }
+    player1.velocityX += impulseX;
+    player1.velocityY += impulseY;
+
+    player2.velocityX -= impulseX;
+    player2.velocityY -= impulseY;
+    // applied once every island is resolved
+    if (player2.hasFlag && player1.team != player2.team) {
+        tags.push_back({&player2, player1.id});
+    }
+    if (player1.hasFlag && player1.team != player2.team) {
+        tags.push_back({&player1, player2.id});
     }
-  }
+}
+
+bool Game::sweptTouches(const PlayerState& player, float x, float y) {
+    // same reach as checkCollision, over the whole step instead of its end;
+    // the path runs to where the player last bounced, then to where it ended
+    float t;
+    return timeOfImpact(player.prevX - x, player.prevY - y,
+                        player.contactX - player.prevX, player.contactY - player.prevY,
+                        playerRadius * 2, t) ||
+           timeOfImpact(player.contactX - x, player.contactY - y,
+                        player.x - player.contactX, player.y - player.contactY,
+                        playerRadius * 2, t);
 }
 
 bool Game::checkCollision(float x1, float y1, float x2, float y2) {
@@ -296,3 +621,8 @@ bool Game::checkCollision(float x1, float y1, float x2, float y2) {
     float distance = std::sqrt(dx * dx + dy * dy);
     return distance < playerRadius * 2 && distance > 0;
 }
+
+template class RulesGame<ClassicRules>;
+template class RulesGame<NoFrictionRules>;
+template class RulesGame<SingleFlagRules>;
+template class RulesGame<RuntimeRules>;
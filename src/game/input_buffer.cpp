@@ -0,0 +1,68 @@
+#include "game/input_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+void InputJitterBuffer::push(const PlayerInput& input, uint32_t serverTick) {
+    // inputs arrive several times through redundant packets; keep the first copy
+    if (input.sequence != 0) {
+        if (input.sequence <= highestSequence) return;
+        highestSequence = input.sequence;
+    }
+
+    // arrival offset between the two clocks; its spread is the jitter
+    float offset = static_cast<float>(static_cast<int64_t>(serverTick) - input.clientTick);
+    if (!hasOffset) {
+        baseOffset = lastOffset = offset;
+        hasOffset = true;
+    }
+    jitter += (std::abs(offset - lastOffset) - jitter) / 16.0f;
+    lastOffset = offset;
+    // follow the fastest transit, but let it creep up so clock drift
+    // between client and server does not leave it stale
+    baseOffset = std::min(offset, baseOffset + 0.01f);
+    delayTicks = std::min(maxDelayTicks, static_cast<uint32_t>(std::ceil(jitter * 2.0f)));
+
+    uint32_t dueTick = serverTick;
+    if (input.sequence != 0) {
+        int64_t scheduled = static_cast<int64_t>(input.clientTick) +
+                            static_cast<int64_t>(std::floor(baseOffset)) + delayTicks;
+        if (scheduled < serverTick) {
+            underruns++;
+        } else {
+            dueTick = static_cast<uint32_t>(scheduled);
+        }
+    }
+
+    if (count >= capacity) {
+        // a newer input supersedes the oldest held one anyway
+        head = (head + 1) % capacity;
+        --count;
+        overruns++;
+    }
+
+    size_t position = count++;
+    while (position > 0 && at(position - 1).input.clientTick > input.clientTick) {
+        at(position) = at(position - 1);
+        --position;
+    }
+    at(position) = {input, dueTick};
+}
+
+bool InputJitterBuffer::pop(uint32_t serverTick, PlayerInput& input) {
+    if (count == 0 || at(0).dueTick > serverTick) return false;
+    input = at(0).input;
+    head = (head + 1) % capacity;
+    --count;
+    return true;
+}
+
+InputBufferStats InputJitterBuffer::getStats() const {
+    InputBufferStats stats;
+    stats.depth = count;
+    stats.delayTicks = delayTicks;
+    stats.jitterTicks = jitter;
+    stats.underruns = underruns;
+    stats.overruns = overruns;
+    return stats;
+}
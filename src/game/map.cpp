@@ -0,0 +1,245 @@
+#include "game/map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include "game/game_state.h"
+#include "network/logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define MAP_LOG(fmt, ...) LOG("[MAP] " fmt, ##__VA_ARGS__)
+
+static_assert(sizeof(MapFileHeader) == 44, "MapFileHeader must match the file layout");
+
+namespace {
+constexpr uint16_t maxMapTiles = 1024; // per side
+constexpr uint16_t maxTileSize = 256;  // pixels
+// pixels per side; keeps the distance field to about a million samples
+// (12 MiB) and its build under a second
+constexpr float maxMapPixels = 4096;
+
+// maps loaded from files, by path; lobbies on the same map share one copy
+std::mutex cacheMutex;
+std::unordered_map<std::string, std::weak_ptr<const Map>> cache;
+}
+
+Map::~Map() {
+    if (!mappedData) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mappedData);
+#else
+    munmap(mappedData, mappedSize);
+#endif
+}
+
+std::shared_ptr<const Map> Map::classic() {
+    static std::shared_ptr<const Map> map = [] {
+        std::shared_ptr<Map> m(new Map());
+        std::memcpy(m->header.magic, "TPMP", 4);
+        m->header.version = mapFormatVersion;
+        m->header.tileSize = 40;
+        m->header.width = 20;
+        m->header.height = 15;
+        m->header.redFlagX = m->header.redSpawnX = 100.0f;
+        m->header.blueFlagX = m->header.blueSpawnX = 700.0f;
+        m->header.redFlagY = m->header.blueFlagY = 300.0f;
+        m->header.redSpawnY = m->header.blueSpawnY = 300.0f;
+        m->ownedTiles.assign(size_t(m->header.width) * m->header.height, TILE_EMPTY);
+        m->tiles = m->ownedTiles.data();
+        m->buildDistanceField();
+        return m;
+    }();
+    return map;
+}
+
+std::shared_ptr<const Map> Map::forId(uint8_t mapId) {
+    if (mapId == 0) return classic();
+    auto map = load("maps/" + std::to_string(mapId) + ".tpmap");
+    if (!map) {
+        MAP_LOG("Map %d unavailable, using the classic arena", mapId);
+        return classic();
+    }
+    return map;
+}
+
+std::shared_ptr<const Map> Map::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto cached = cache.find(path);
+    if (cached != cache.end()) {
+        if (auto map = cached->second.lock()) return map;
+    }
+
+    std::shared_ptr<Map> map(new Map());
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        MAP_LOG("Cannot open %s", path.c_str());
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        map->mappedData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    map->mappedSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        MAP_LOG("Cannot open %s", path.c_str());
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        map->mappedSize = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, map->mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) map->mappedData = data;
+    }
+    close(fd);
+#endif
+    if (!map->mappedData) {
+        MAP_LOG("Cannot map %s", path.c_str());
+        return nullptr;
+    }
+
+    if (map->mappedSize < sizeof(MapFileHeader)) {
+        MAP_LOG("%s is too small to be a map", path.c_str());
+        return nullptr;
+    }
+    std::memcpy(&map->header, map->mappedData, sizeof(MapFileHeader));
+    const MapFileHeader& h = map->header;
+    size_t tileCount = size_t(h.width) * h.height;
+    if (std::memcmp(h.magic, "TPMP", 4) != 0 || h.version != mapFormatVersion ||
+        h.tileSize == 0 || h.width == 0 || h.height == 0 ||
+        h.width > maxMapTiles || h.height > maxMapTiles ||
+        map->mappedSize < sizeof(MapFileHeader) + tileCount) {
+        MAP_LOG("%s is not a version %d map", path.c_str(), mapFormatVersion);
+        return nullptr;
+    }
+    // checked before the distance field, whose size follows the pixel size
+    if (h.tileSize > maxTileSize || map->getWidth() > maxMapPixels || map->getHeight() > maxMapPixels) {
+        MAP_LOG("%s is too large (%dx%d tiles of %d px, at most %g px a side)", path.c_str(), h.width, h.height,
+                h.tileSize, maxMapPixels);
+        return nullptr;
+    }
+    map->tiles = static_cast<const uint8_t*>(map->mappedData) + sizeof(MapFileHeader);
+    map->buildDistanceField();
+
+    MAP_LOG("Loaded %s (%dx%d tiles of %d px)", path.c_str(), h.width, h.height, h.tileSize);
+    cache[path] = map;
+    return map;
+}
+
+bool Map::isWall(int tileX, int tileY) const {
+    if (tileX < 0 || tileY < 0 || tileX >= header.width || tileY >= header.height) return true;
+    return tiles[size_t(tileY) * header.width + tileX] == TILE_WALL;
+}
+
+float Map::getFlagX(uint8_t team) const { return team == REDTEAM ? header.redFlagX : header.blueFlagX; }
+float Map::getFlagY(uint8_t team) const { return team == REDTEAM ? header.redFlagY : header.blueFlagY; }
+float Map::getSpawnX(uint8_t team) const { return team == REDTEAM ? header.redSpawnX : header.blueSpawnX; }
+float Map::getSpawnY(uint8_t team) const { return team == REDTEAM ? header.redSpawnY : header.blueSpawnY; }
+
+float Map::exactDistance(float x, float y, float& normalX, float& normalY) const {
+    // outside a wall: distance to the closest wall tile; inside one: to the
+    // closest open tile. Only tiles within fieldRange are considered.
+    const float size = header.tileSize;
+    int tileX = static_cast<int>(std::floor(x / size));
+    int tileY = static_cast<int>(std::floor(y / size));
+    bool inside = isWall(tileX, tileY);
+    int reach = static_cast<int>(std::ceil(fieldRange / size));
+
+    float best = fieldRange;
+    normalX = normalY = 0;
+    for (int ty = tileY - reach; ty <= tileY + reach; ++ty) {
+        for (int tx = tileX - reach; tx <= tileX + reach; ++tx) {
+            if (isWall(tx, ty) == inside) continue;
+            float closestX = std::clamp(x, tx * size, (tx + 1) * size);
+            float closestY = std::clamp(y, ty * size, (ty + 1) * size);
+            float dx = x - closestX;
+            float dy = y - closestY;
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (distance < best) {
+                best = distance;
+                float sign = inside ? -1.0f : 1.0f;
+                if (distance > 0) {
+                    normalX = sign * dx / distance;
+                    normalY = sign * dy / distance;
+                } else {
+                    // on the tile's edge: face out of the side we are on
+                    float offsetX = x - (tx + 0.5f) * size;
+                    float offsetY = y - (ty + 0.5f) * size;
+                    bool horizontal = std::abs(offsetX) >= std::abs(offsetY);
+                    normalX = horizontal ? sign * std::copysign(1.0f, offsetX) : 0;
+                    normalY = horizontal ? 0 : sign * std::copysign(1.0f, offsetY);
+                }
+            }
+        }
+    }
+    return inside ? -best : best;
+}
+
+void Map::buildDistanceField() {
+    fieldWidth = static_cast<size_t>(std::ceil(getWidth() / fieldCellSize));
+    fieldHeight = static_cast<size_t>(std::ceil(getHeight() / fieldCellSize));
+    field.resize((fieldWidth + 1) * (fieldHeight + 1));
+    for (size_t j = 0; j <= fieldHeight; ++j) {
+        for (size_t i = 0; i <= fieldWidth; ++i) {
+            FieldSample& sample = field[j * (fieldWidth + 1) + i];
+            sample.distance = exactDistance(i * fieldCellSize, j * fieldCellSize,
+                                            sample.normalX, sample.normalY);
+        }
+    }
+}
+
+float Map::distanceToWall(float x, float y, float& normalX, float& normalY) const {
+    float fx = x / fieldCellSize;
+    float fy = y / fieldCellSize;
+    if (fx < 0 || fy < 0 || fx >= fieldWidth || fy >= fieldHeight) {
+        // off the field (a player that left the arena); rare, so solve it directly
+        return exactDistance(x, y, normalX, normalY);
+    }
+
+    // bilinear blend of the four surrounding corners
+    size_t i = static_cast<size_t>(fx);
+    size_t j = static_cast<size_t>(fy);
+    float u = fx - i;
+    float v = fy - j;
+    const FieldSample& a = field[j * (fieldWidth + 1) + i];
+    const FieldSample& b = field[j * (fieldWidth + 1) + i + 1];
+    const FieldSample& c = field[(j + 1) * (fieldWidth + 1) + i];
+    const FieldSample& d = field[(j + 1) * (fieldWidth + 1) + i + 1];
+    auto blend = [u, v](float a, float b, float c, float d) {
+        return (a * (1 - u) + b * u) * (1 - v) + (c * (1 - u) + d * u) * v;
+    };
+    float distance = blend(a.distance, b.distance, c.distance, d.distance);
+    if (distance >= fieldRange / 2) {
+        // nowhere near a wall; the normals out here are not meaningful
+        normalX = normalY = 0;
+        return distance;
+    }
+
+    normalX = blend(a.normalX, b.normalX, c.normalX, d.normalX);
+    normalY = blend(a.normalY, b.normalY, c.normalY, d.normalY);
+    float length = std::sqrt(normalX * normalX + normalY * normalY);
+    if (length < 1e-3f) {
+        // corners disagree (a thin wall or a saddle); ask the tiles
+        return exactDistance(x, y, normalX, normalY);
+    }
+    normalX /= length;
+    normalY /= length;
+    return distance;
+}
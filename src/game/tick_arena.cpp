@@ -0,0 +1,29 @@
+#include "game/tick_arena.h"
+
+#include <algorithm>
+
+void* TickArena::Spill::do_allocate(size_t bytes, size_t alignment) {
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void TickArena::Spill::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+TickArena::TickArena(size_t initialBytes)
+    : block(new std::byte[initialBytes]), blockBytes(initialBytes) {
+    arena.emplace(block.get(), blockBytes, &spill);
+}
+
+void TickArena::reset() {
+    arena->release();
+    if (spill.bytes == 0) return;
+
+    // the last tick did not fit; make room for it with some to spare
+    blockBytes = std::max(blockBytes * 2, blockBytes + spill.bytes);
+    spill.bytes = 0;
+    arena.reset();
+    block.reset(new std::byte[blockBytes]);
+    arena.emplace(block.get(), blockBytes, &spill);
+}
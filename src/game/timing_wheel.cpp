@@ -0,0 +1,137 @@
+#include "game/timing_wheel.h"
+
+TimingWheel::TimerId TimingWheel::schedule(uint64_t delay, Callback callback) {
+    uint32_t index;
+    if (!freeNodes.empty()) {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes.back().generation = 1;
+    }
+    Node& node = nodes[index];
+    node.deadline = current + (delay > 0 ? delay : 1);
+    node.callback = std::move(callback);
+    place(index);
+    ++count;
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes.size()) return false;
+    Node& node = nodes[index];
+    if (node.generation != generation || node.list == nil) return false;
+    unlink(index);
+    release(index);
+    --count;
+    return true;
+}
+
+void TimingWheel::advance(uint64_t now) {
+    while (current < now) {
+        if (count == 0) {
+            // nothing to fire or cascade on the way
+            current = now;
+            return;
+        }
+        ++current;
+
+        // when a wheel completes a turn, spread the next slot of the wheel
+        // above over the ones below, top wheel first
+        int top = 0;
+        while (top < levels - 1 && (current & ((1ull << (slotBits * (top + 1))) - 1)) == 0) {
+            ++top;
+        }
+        for (int level = top; level > 0; --level) {
+            cascade(level);
+        }
+
+        // detach the due slot first so callbacks can schedule into it
+        List& due = lists[current & slotMask];
+        for (uint32_t index = due.head; index != nil; index = nodes[index].next) {
+            nodes[index].list = firingList;
+        }
+        lists[firingList] = due;
+        due = List{};
+
+        while (lists[firingList].head != nil) {
+            uint32_t index = lists[firingList].head;
+            unlink(index);
+            Callback callback = std::move(nodes[index].callback);
+            release(index);
+            --count;
+            callback();
+        }
+    }
+}
+
+void TimingWheel::clear() {
+    for (uint32_t index = 0; index < nodes.size(); ++index) {
+        if (nodes[index].list != nil) release(index);
+    }
+    lists.fill(List{});
+    count = 0;
+}
+
+void TimingWheel::place(uint32_t index) {
+    Node& node = nodes[index];
+    uint64_t delta = node.deadline - current;
+    int level = 0;
+    while (level < levels - 1 && delta >= (1ull << (slotBits * (level + 1)))) {
+        ++level;
+    }
+    // past the top wheel's range: park in its furthest slot and re-place
+    // from there when it comes around
+    uint64_t when = delta >= (1ull << (slotBits * levels))
+        ? current + (1ull << (slotBits * levels)) - 1
+        : node.deadline;
+    uint32_t slot = static_cast<uint32_t>(when >> (slotBits * level)) & slotMask;
+    link(index, level * slotsPerLevel + slot);
+}
+
+void TimingWheel::link(uint32_t index, uint32_t list) {
+    Node& node = nodes[index];
+    List& target = lists[list];
+    node.list = list;
+    node.prev = target.tail;
+    node.next = nil;
+    if (target.tail != nil) {
+        nodes[target.tail].next = index;
+    } else {
+        target.head = index;
+    }
+    target.tail = index;
+}
+
+void TimingWheel::unlink(uint32_t index) {
+    Node& node = nodes[index];
+    List& source = lists[node.list];
+    if (node.prev != nil) nodes[node.prev].next = node.next; else source.head = node.next;
+    if (node.next != nil) nodes[node.next].prev = node.prev; else source.tail = node.prev;
+    node.prev = node.next = nil;
+    node.list = nil;
+}
+
+void TimingWheel::release(uint32_t index) {
+    Node& node = nodes[index];
+    node.callback = nullptr;
+    node.list = nil;
+    if (++node.generation == 0) node.generation = 1; // ids are never 0
+    freeNodes.push_back(index);
+}
+
+void TimingWheel::cascade(int level) {
+    uint32_t slot = static_cast<uint32_t>(current >> (slotBits * level)) & slotMask;
+    List pending = lists[level * slotsPerLevel + slot];
+    lists[level * slotsPerLevel + slot] = List{};
+    // re-placing keeps scheduling order, as nodes are appended in list order
+    for (uint32_t index = pending.head; index != nil;) {
+        uint32_t next = nodes[index].next;
+        nodes[index].prev = nodes[index].next = nil;
+        place(index);
+        index = next;
+    }
+}
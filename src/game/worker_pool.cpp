@@ -0,0 +1,117 @@
+#include "game/worker_pool.h"
+
+#include <algorithm>
+
+namespace {
+// which pool and deque the current thread works for, if any
+thread_local const WorkerPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+}
+
+WorkerPool::WorkerPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void WorkerPool::submit(Task task) {
+    size_t index = currentPool == this
+        ? currentIndex
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // taken so a worker between its last check and wait() cannot miss this
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    struct Batch {
+        const std::function<void(size_t)>* body;
+        size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+    };
+    // helpers that only get to run after we return find no work left,
+    // but still touch the batch, so it is shared with them
+    auto batch = std::make_shared<Batch>();
+    batch->body = &body;
+    batch->count = count;
+    auto work = [](Batch& b) {
+        size_t index;
+        while ((index = b.next.fetch_add(1)) < b.count) {
+            (*b.body)(index);
+            ++b.done;
+        }
+    };
+
+    size_t helpers = std::min(count, workers.size()) - (count > 0 ? 1 : 0);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([batch, work] { work(*batch); });
+    }
+    work(*batch);
+    // whatever is left is already running on other threads
+    while (batch->done < count) {
+        std::this_thread::yield();
+    }
+}
+
+bool WorkerPool::popLocal(size_t index, Task& task) {
+    TaskQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkerPool::steal(size_t thief, Task& task) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        TaskQueue& queue = *queues[(thief + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        ++stolen;
+        return true;
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            --pending;
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return pending > 0 || !running; });
+        if (!running && pending == 0) break;
+    }
+}
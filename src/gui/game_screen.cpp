@@ -2,6 +2,7 @@
 
 #include <QDebug>
 #include <QGraphicsTextItem>
+#include <cmath>
 #include <QVBoxLayout>
 #include "game/game.h"
 
@@ -20,10 +21,14 @@ QVector2D InputHandler::getInputVector() const {
 GameScreen::GameScreen(QWidget* parent) : QWidget(parent) {
   setupScene();
   setupScoreDisplay();
+  setupEventFeed();
+  setupPerfOverlay();
 
+  // inputs are sent as soon as they change; this heartbeat only
+  // re-sends the held input in case the server missed it
   inputTimer = new QTimer(this);
-  connect(inputTimer, &QTimer::timeout, this, &GameScreen::sendPlayerInput);
-  inputTimer->start(16); // ~60fps
+  connect(inputTimer, &QTimer::timeout, this, [this]() { sendPlayerInput(); });
+  inputTimer->start(250);
 
   view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -32,7 +37,10 @@ GameScreen::GameScreen(QWidget* parent) : QWidget(parent) {
   view->setFrameShape(QFrame::NoFrame);
 }
 
-GameScreen::~GameScreen() { inputTimer->stop(); }
+GameScreen::~GameScreen() {
+  inputTimer->stop();
+  perfTimer->stop();
+}
 
 void GameScreen::setupScene() {
   QVBoxLayout* layout = new QVBoxLayout(this);
@@ -42,20 +50,50 @@ void GameScreen::setupScene() {
   layout->setContentsMargins(0, 0, 0, 0);
   layout->setSpacing(0);
 
-  scene->setSceneRect(0, 0, Game::arenaWidth, Game::arenaHeight);
+  scene->setSceneRect(0, 0, map->getWidth(), map->getHeight());
   scene->setBackgroundBrush(QBrush(QColor(50, 50, 50)));
 
-  QGraphicsLineItem* centerLine =
-      scene->addLine(400, 0, 400, 600, QPen(Qt::white, 2, Qt::DashLine));
+  centerLine = scene->addLine(map->getWidth() / 2, 0, map->getWidth() / 2, map->getHeight(),
+                              QPen(Qt::white, 2, Qt::DashLine));
   centerLine->setZValue(-1);
 
   // Add a debug rectangle representing the arena boundaries
-  // QGraphicsRectItem* bounds = scene->addRect(0, 0, Game::arenaWidth, Game::arenaHeight, QPen(Qt::red, 2));
+  // QGraphicsRectItem* bounds = scene->addRect(0, 0, map->getWidth(), map->getHeight(), QPen(Qt::red, 2));
   // bounds->setZValue(0); // Draw behind players
 }
 
+void GameScreen::setMap(uint8_t newMapId) {
+  mapId = newMapId;
+  map = Map::forId(mapId);
+  float width = map->getWidth();
+  float height = map->getHeight();
+
+  scene->setSceneRect(0, 0, width, height);
+  centerLine->setLine(width / 2, 0, width / 2, height);
+  scoreBackground->setRect(0, 0, width, 40);
+  blueScoreText->setPos(width - 120, 5);
+  blueLabel->setPos(width - 90, 10);
+  eventFeedText->setPos(5, height - 20 * eventFeedLines - 10);
+
+  for (QGraphicsRectItem* wall : wallGraphics) {
+    scene->removeItem(wall);
+    delete wall;
+  }
+  wallGraphics.clear();
+  int size = map->getTileSize();
+  for (int y = 0; y < map->getHeightInTiles(); ++y) {
+    for (int x = 0; x < map->getWidthInTiles(); ++x) {
+      if (!map->isWall(x, y)) continue;
+      QGraphicsRectItem* wall = scene->addRect(x * size, y * size, size, size,
+                                               QPen(Qt::transparent), QBrush(QColor(90, 90, 90)));
+      wall->setZValue(0);
+      wallGraphics.append(wall);
+    }
+  }
+}
+
 void GameScreen::setupScoreDisplay() {
-  scoreBackground = scene->addRect(0, 0, Game::arenaWidth, 40);
+  scoreBackground = scene->addRect(0, 0, map->getWidth(), 40);
   scoreBackground->setBrush(QBrush(QColor(30, 30, 30, 200)));
   scoreBackground->setPen(QPen(Qt::transparent));
   scoreBackground->setZValue(10);
@@ -70,11 +108,11 @@ void GameScreen::setupScoreDisplay() {
   blueScoreText = scene->addText("0");
   blueScoreText->setFont(scoreFont);
   blueScoreText->setDefaultTextColor(QColor(100, 100, 255)); // blue
-  blueScoreText->setPos(Game::arenaWidth - 120, 5);
+  blueScoreText->setPos(map->getWidth() - 120, 5);
   blueScoreText->setZValue(11);
 
   QGraphicsTextItem* redLabel = scene->addText("RED");
-  QGraphicsTextItem* blueLabel = scene->addText("BLUE");
+  blueLabel = scene->addText("BLUE");
 
   QFont labelFont("Arial", 14);
   redLabel->setFont(labelFont);
@@ -84,11 +122,161 @@ void GameScreen::setupScoreDisplay() {
   blueLabel->setDefaultTextColor(QColor(100, 100, 255));
 
   redLabel->setPos(50, 10);
-  blueLabel->setPos(Game::arenaWidth - 90, 10);
+  blueLabel->setPos(map->getWidth() - 90, 10);
   redLabel->setZValue(11);
   blueLabel->setZValue(11);
 }
 
+void GameScreen::setupEventFeed() {
+  eventFeedText = scene->addText("");
+  eventFeedText->setFont(QFont("Arial", 11));
+  eventFeedText->setDefaultTextColor(Qt::white);
+  eventFeedText->setPos(5, map->getHeight() - 20 * eventFeedLines - 10);
+  eventFeedText->setZValue(12);
+}
+
+QString GameScreen::getPlayerName(uint32_t playerId) const {
+  auto nameTag = playerNames.constFind(playerId);
+  return nameTag != playerNames.constEnd() ? nameTag.value()->toPlainText()
+                                           : QString("Player%1").arg(playerId);
+}
+
+void GameScreen::applyGameEvents(const std::vector<GameEvent>& events) {
+  for (const GameEvent& event : events) {
+    QString name = getPlayerName(event.playerId);
+    QString line;
+    switch (event.kind) {
+    case EVENT_FLAG_TAKEN:
+      line = QString("%1 took the flag").arg(name);
+      break;
+    case EVENT_CAPTURE:
+      line = QString("%1 scored for %2").arg(name, event.team == REDTEAM ? "red" : "blue");
+      break;
+    case EVENT_POP:
+      line = QString("%1 popped %2").arg(getPlayerName(event.otherId), name);
+      break;
+    default:
+      continue; // respawns are visible on the field
+    }
+    eventFeed.append(line);
+    if (eventFeed.size() > eventFeedLines) eventFeed.removeFirst();
+    QTimer::singleShot(eventFeedMs, this, [this, line]() {
+      eventFeed.removeOne(line);
+      updateEventFeed();
+    });
+  }
+  updateEventFeed();
+}
+
+void GameScreen::updateEventFeed() {
+  eventFeedText->setPlainText(eventFeed.join('\n'));
+}
+
+void GameScreen::setupPerfOverlay() {
+  perfText = scene->addText("");
+  perfText->setFont(QFont("Courier", 10));
+  perfText->setDefaultTextColor(Qt::white);
+  perfText->setPos(5, 45);
+  perfText->setZValue(12);
+
+  perfBackground = new QGraphicsRectItem(perfText);
+  perfBackground->setBrush(QBrush(QColor(0, 0, 0, 160)));
+  perfBackground->setPen(QPen(Qt::transparent));
+  perfBackground->setFlag(QGraphicsItem::ItemStacksBehindParent);
+  perfText->setVisible(false);
+
+  // count repaints of the view to get the render rate
+  view->viewport()->installEventFilter(this);
+  perfClock.start();
+
+  perfTimer = new QTimer(this);
+  connect(perfTimer, &QTimer::timeout, this, &GameScreen::updatePerfOverlay);
+}
+
+void GameScreen::togglePerfOverlay() {
+  bool visible = !perfText->isVisible();
+  perfText->setVisible(visible);
+  if (visible) {
+    lastPerfUpdateMs = perfClock.elapsed();
+    framesRendered = snapshotsReceived = 0;
+    if (localClient) {
+      lastBytesSent = localClient->getBytesSent();
+      lastBytesReceived = localClient->getBytesReceived();
+    }
+    perfTimer->start(500);
+  } else {
+    perfTimer->stop();
+  }
+}
+
+void GameScreen::updatePerfOverlay() {
+  qint64 now = perfClock.elapsed();
+  double seconds = (now - lastPerfUpdateMs) / 1000.0;
+  if (seconds <= 0) return;
+
+  double bytesOutPerSec = 0, bytesInPerSec = 0, rttMs = 0, rttJitterMs = 0;
+  if (localClient) {
+    uint64_t sent = localClient->getBytesSent();
+    uint64_t received = localClient->getBytesReceived();
+    bytesOutPerSec = (sent - lastBytesSent) / seconds;
+    bytesInPerSec = (received - lastBytesReceived) / seconds;
+    lastBytesSent = sent;
+    lastBytesReceived = received;
+    rttMs = localClient->getRttMs();
+    rttJitterMs = localClient->getJitterMs();
+  }
+
+  QString text = QString("FPS        %1\n"
+                         "Snapshots  %2/s  jitter %3 ms\n"
+                         "In / Out   %4 / %5 B/s\n"
+                         "RTT        %6 ms  +/- %10 ms\n"
+                         "Tick       %7  (%8 us)\n"
+                         "Input lag  %9")
+      .arg(framesRendered / seconds, 0, 'f', 0)
+      .arg(snapshotsReceived / seconds, 0, 'f', 0)
+      .arg(snapshotJitterMs, 0, 'f', 1)
+      .arg(bytesInPerSec, 0, 'f', 0)
+      .arg(bytesOutPerSec, 0, 'f', 0)
+      .arg(rttMs, 0, 'f', 1)
+      .arg(serverTick)
+      .arg(serverTickDurationUs)
+      .arg(inputLatencyMs < 0 ? QString("-") : QString("%1 ms").arg(inputLatencyMs, 0, 'f', 1))
+      .arg(rttJitterMs, 0, 'f', 1);
+  perfText->setPlainText(text);
+  perfBackground->setRect(perfText->boundingRect());
+
+  framesRendered = snapshotsReceived = 0;
+  lastPerfUpdateMs = now;
+}
+
+void GameScreen::recordSnapshotArrival(const GameState& state) {
+  qint64 now = perfClock.elapsed();
+  if (lastSnapshotMs >= 0) {
+    double interval = now - lastSnapshotMs;
+    snapshotJitterMs += (std::abs(interval - snapshotIntervalMs) - snapshotJitterMs) / 16.0;
+    snapshotIntervalMs = interval;
+  }
+  lastSnapshotMs = now;
+  snapshotsReceived++;
+  serverTick = state.tick;
+  serverTickDurationUs = state.tickDurationUs;
+
+  if (inputPending && localClient) {
+    auto it = state.players.find(localClient->getPlayerId());
+    if (it != state.players.end() && it->second.lastInputSeq >= pendingInputSeq) {
+      inputLatencyMs = now - pendingInputMs;
+      inputPending = false;
+    }
+  }
+}
+
+bool GameScreen::eventFilter(QObject* watched, QEvent* event) {
+  if (event->type() == QEvent::Paint && watched == view->viewport()) {
+    framesRendered++;
+  }
+  return QWidget::eventFilter(watched, event);
+}
+
 void GameScreen::updateScoreDisplay(uint8_t redScore, uint8_t blueScore) {
   if (redScoreText) {
     redScoreText->setPlainText(QString::number(redScore));
@@ -99,6 +287,10 @@ void GameScreen::updateScoreDisplay(uint8_t redScore, uint8_t blueScore) {
 }
 
 void GameScreen::applyGameState(const GameState& state) {
+  if (state.mapId != mapId) {
+    setMap(state.mapId);
+  }
+  recordSnapshotArrival(state);
   updateScoreDisplay(state.redScore, state.blueScore);
 
   for (const auto& [id, playerState] : state.players) {
@@ -138,7 +330,7 @@ void GameScreen::updateRedFlag(uint32_t redFlag) {
     if (player != playerGraphics.constEnd()) {
         flag->setPos(player.value()->pos() + QPointF(0.0f, -20.0f));
     } else {
-        flag->setPos(Game::redFlagX, Game::redFlagY);
+        flag->setPos(map->getFlagX(REDTEAM), map->getFlagY(REDTEAM));
     }
 }
 
@@ -165,7 +357,7 @@ void GameScreen::updateBlueFlag(uint32_t blueFlag) {
     if (player != playerGraphics.constEnd()) {
         flag->setPos(player.value()->pos() + QPointF(0.0f, -20.0f));
     } else {
-        flag->setPos(Game::blueFlagX, Game::blueFlagY);
+        flag->setPos(map->getFlagX(BLUETEAM), map->getFlagY(BLUETEAM));
     }
 }
 
@@ -220,7 +412,14 @@ QColor GameScreen::getTeamColor(uint8_t team) {
 }
 
 void GameScreen::keyPressEvent(QKeyEvent* event) {
+  if (event->key() == Qt::Key_F3 && !event->isAutoRepeat()) {
+    togglePerfOverlay();
+    event->accept();
+    return;
+  }
+
   // update local player input
+  QVector2D before = inputs.getInputVector();
   switch (event->key()) {
     case Qt::Key_W:
     case Qt::Key_Up: inputs.keyPressed(Qt::Key_Up); break;
@@ -231,11 +430,13 @@ void GameScreen::keyPressEvent(QKeyEvent* event) {
     case Qt::Key_D:
     case Qt::Key_Right: inputs.keyPressed(Qt::Key_Right); break;
   }
+  onInputChanged(before);
   event->accept();
 }
 
 void GameScreen::keyReleaseEvent(QKeyEvent* event) {
   // update local player input
+  QVector2D before = inputs.getInputVector();
   switch (event->key()) {
     case Qt::Key_W:
     case Qt::Key_Up: inputs.keyReleased(Qt::Key_Up); break;
@@ -246,11 +447,23 @@ void GameScreen::keyReleaseEvent(QKeyEvent* event) {
     case Qt::Key_D:
     case Qt::Key_Right: inputs.keyReleased(Qt::Key_Right); break;
   }
+  onInputChanged(before);
   event->accept();
 }
 
-void GameScreen::sendPlayerInput() {
-  if (!localClient) return;
+uint32_t GameScreen::sendPlayerInput() {
+  if (!localClient) return 0;
   QVector2D input = inputs.getInputVector();
-  localClient->sendPlayerInput(input.x(), input.y());
+  return localClient->sendPlayerInput(input.x(), input.y());
+}
+
+void GameScreen::onInputChanged(const QVector2D& before) {
+  if (inputs.getInputVector() == before) return;
+  qint64 now = perfClock.elapsed();
+  uint32_t sequence = sendPlayerInput();
+  if (!inputPending && sequence != 0) {
+    inputPending = true;
+    pendingInputSeq = sequence;
+    pendingInputMs = now;
+  }
 }
@@ -13,7 +13,7 @@
 LobbyScreen::LobbyScreen(QWidget* parent) : QWidget(parent) {
     QVBoxLayout* layout = new QVBoxLayout(this);
 
-    QLabel* title = new QLabel("Lobby");
+    title = new QLabel("Lobby");
     title->setObjectName("screenTitle");
 
     playerList = new QListWidget();
@@ -50,6 +50,10 @@ void LobbyScreen::setHost(bool host) {
     startGameBtn->setVisible(host);
 }
 
+void LobbyScreen::setLobbyId(uint32_t id) {
+    title->setText(QString("Lobby %1").arg(id));
+}
+
 // Start screen implementation:
 StartScreen::StartScreen(QWidget* parent) : QWidget(parent) {
   setupUI();
@@ -70,16 +74,19 @@ void StartScreen::onLobbyLeave() {
 void StartScreen::onBackClicked() { returnToMainMenu(); }
 void StartScreen::onHostClicked() { stackedWidget->setCurrentIndex(1); }
 void StartScreen::onJoinClicked() { stackedWidget->setCurrentIndex(2); }
-void StartScreen::onHostCreateLobby(QString port) {
+void StartScreen::onHostCreateLobby(QString port, uint8_t mapId, GameMode mode) {
     if (port.isEmpty()) {
         port = "12345";
     }
-    server = new Server(port.toUShort());
+    server = new Server(port.toUShort(), mapId, mode);
     if (server->init()) {
         server->start(true);
 
-        // let this host join as a client to their own server
-        onClientJoinGame("127.0.0.1", port);
+        // let this host join their own server in-process, skipping the
+        // loopback socket and the framing of every snapshot
+        client = new Client();
+        setupClientCallbacks(); // callbacks before connecting
+        client->connect(server->connectLocal());
     } else {
         LOG("[StartScreen] Failed to start server");
         cleanupServer();
@@ -144,6 +151,24 @@ void StartScreen::onClientMessageReceived(const std::string& message) {
             }
             break;
         }
+        case Protocol::GAME_EVENTS: {
+            uint32_t lobbyId;
+            std::vector<GameEvent> events;
+            if (stackedWidget->currentWidget() == gameScreen &&
+                Protocol::deserializeGameEvents(message, lobbyId, events)) {
+                gameScreen->applyGameEvents(events);
+            }
+            break;
+        }
+        case Protocol::LOBBY_JOINED: {
+            uint32_t lobbyId;
+            if (Protocol::deserializeLobbyJoined(message, lobbyId)) {
+                // host status follows separately if this lobby is ours
+                lobbyScreen->setLobbyId(lobbyId);
+                lobbyScreen->setHost(false);
+            }
+            break;
+        }
         case Protocol::MARK_CLIENT_HOST: {
             lobbyScreen->setHost(true);
             break;
@@ -210,12 +235,9 @@ void StartScreen::returnToMainMenu() {
 }
 
 void StartScreen::onLobbyHostStartGame() {
-    if (server) {
-        server->start_game();
-    } else {
-      std::string message = Protocol::serializeRequestStartGame();
-      std::string framed = Protocol::frameMessage(message);
-      client->sendMessage(message);
+    // the server only starts the lobby if we are still its host
+    if (client) {
+      client->sendMessage(Protocol::serializeRequestStartGame());
     }
 }
 
@@ -261,7 +283,10 @@ QWidget* StartScreen::createHostScreen() {
   portInput->setPlaceholderText("Port");
 
   QComboBox* mapCombo = new QComboBox();
-  mapCombo->addItems({"Classic"});
+  mapCombo->addItems({"Classic", "Pillars"}); // index is the map id
+
+  QComboBox* modeCombo = new QComboBox();
+  modeCombo->addItems({"Classic", "No Friction", "Single Flag"}); // index is the GameMode
 
   QComboBox* maxPlayers = new QComboBox();
   maxPlayers->addItems({"4"});
@@ -279,13 +304,15 @@ QWidget* StartScreen::createHostScreen() {
   layout->addSpacing(20);
   layout->addWidget(portInput);
   layout->addWidget(mapCombo);
+  layout->addWidget(modeCombo);
   layout->addWidget(maxPlayers);
   layout->addStretch();
   layout->addLayout(buttons);
 
   connect(backBtn, &QPushButton::clicked, this, &StartScreen::onBackClicked);
-  connect(startBtn, &QPushButton::clicked, this, [this, portInput]() {
-    onHostCreateLobby(portInput->text());
+  connect(startBtn, &QPushButton::clicked, this, [this, portInput, mapCombo, modeCombo]() {
+    onHostCreateLobby(portInput->text(), static_cast<uint8_t>(mapCombo->currentIndex()),
+                      static_cast<GameMode>(modeCombo->currentIndex()));
   });
 
   return widget;
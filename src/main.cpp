@@ -1,43 +1,14 @@
 #include <QApplication>
 #include <QMainWindow>
 
-#include <csignal>
+#include <cstring>
 #include "gui/start_screen.h"
-#include "network/server.h"
-
-std::mutex consoleMutex;
-
-std::atomic<bool> running{true};
-void signalHandler(int signum) {
-    running = false;
-    printf("\n[Server] Shutdown signal received (%d)\n", signum);
-}
+#include "network/dedicated_server.h"
 
 int main(int argc, char* argv[]) {
+  // same as tagpro_server, for players without a separate server binary
   if (argc > 1 && strcmp(argv[1], "--server") == 0) {
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
-
-    unsigned int port = 12345;
-    if (argc > 2) port = atoi(argv[2]);
-
-    Server server(port);
-    if (!server.init()) {
-      printf("Failed to start server on port %d\n", port);
-      return 1;
-    }
-
-    printf("Server started on port %d\n", port);
-    printf("Press Ctrl+C to stop\n");
-
-    server.start(false);
-    while (running) {
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
-
-    server.stop();
-
-    return 0;
+    return runDedicatedServer(argc - 2, argv + 2);
   }
 
   QApplication app(argc, argv);
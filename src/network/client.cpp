@@ -2,31 +2,38 @@
 #include "network/network.h"
 #include "network/protocol.h"
 
-Client::Client(): clientSocket(INVALID_SOCKET) {
-    createSocket();
+#include <chrono>
+#include <cstdlib>
+
+Client::Client() {
+    if (const char* loss = std::getenv("TAGPRO_SIM_INPUT_LOSS")) {
+        simulatedInputLoss = std::atof(loss);
+    }
 }
 
 Client::~Client() { disconnect(); }
 
-void Client::createSocket() {
+SOCKET Client::createSocket() {
     if (!initSockets()) {
         LOG("[Client] Socket initialization failed.");
-        return;
+        return INVALID_SOCKET;
     }
+    socketsInitialized = true;
 
-    clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+    SOCKET clientSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (clientSocket == INVALID_SOCKET) {
         LOG("[Client] Error creating socket.");
         cleanupSockets();
-        return;
+        socketsInitialized = false;
     }
+    return clientSocket;
 }
 
 void Client::connect(int port, const char * ip) {
     // Might be connected to a different server;
     // In this case, the user of this class should create a
     // new Client object.
-    if (isRunning) {
+    if (isRunning || connection) {
         LOG("[Client] Connection failed. Is this already connected to another server?");
         return;
     }
@@ -41,14 +48,28 @@ void Client::connect(int port, const char * ip) {
         return;
     }
 
-    if (::connect(this->clientSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+    SOCKET clientSocket = createSocket();
+    if (clientSocket == INVALID_SOCKET) return;
+
+    if (::connect(clientSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
         LOG("[Client] Connection failed to %s:%d", ip, port);
-        closeSocket(this->clientSocket);
+        closeSocket(clientSocket);
         cleanupSockets();
+        socketsInitialized = false;
         return;
     }
 
     LOG("[Client] Connected successfully to %s:%d", ip, port);
+    connect(std::make_shared<TcpConnection>(clientSocket));
+}
+
+void Client::connect(std::shared_ptr<Connection> newConnection) {
+    if (isRunning || connection || !newConnection) {
+        LOG("[Client] Connection failed. Is this already connected to another server?");
+        return;
+    }
+    connection = std::move(newConnection);
+    connectTime = std::chrono::steady_clock::now();
 
     {
       std::lock_guard<std::mutex> lock(callbackMutex);
@@ -58,16 +79,15 @@ void Client::connect(int port, const char * ip) {
     }
     isRunning = true;
     receivingThread = std::thread(&Client::receiveLoop, this);
+    pingThread = std::thread(&Client::pingLoop, this);
 }
 
 void Client::disconnect() {
     LOG("[Client] Disconnecting from server.");
     isRunning = false;
 
-    if (clientSocket != INVALID_SOCKET) {
-        shutdownSocket(clientSocket);
-        closeSocket(clientSocket);
-        clientSocket = INVALID_SOCKET;
+    if (connection) {
+        connection->close();
     }
 
     LOG("[Client] Waiting for receivingThread...");
@@ -79,28 +99,25 @@ void Client::disconnect() {
         }
     }
     LOG("[Client] receivingThread has joined.");
+    if (pingThread.joinable()) {
+        if (std::this_thread::get_id() != pingThread.get_id()) {
+            pingThread.join();
+        } else {
+            pingThread.detach();
+        }
+    }
 
-    cleanupSockets();
+    if (socketsInitialized) {
+        cleanupSockets();
+        socketsInitialized = false;
+    }
     LOG("[Client] Disconnected cleanly.");
 }
 
 void Client::receiveLoop() {
-    char buffer[1024];
     while (isRunning) {
-        memset(buffer, 0, sizeof(buffer));
-        int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-
-        if (bytesReceived > 0) {
-            buffer[bytesReceived] = '\0';
-
-            {
-                std::lock_guard<std::mutex> lock(bufferMutex);
-                receiveBuffer.append(buffer);
-            }
-            // LOG("[Client] Received %d bytes, buffer size: %zu", bytesReceived, receiveBuffer.size());
-
-            processIncomingData();
-        } else {
+        MessagePtr message = connection->receive();
+        if (!message) {
             if (isRunning) {
               LOG("[Client] Server disconnected");
               {
@@ -112,45 +129,103 @@ void Client::receiveLoop() {
             }
             break;
         }
+        processMessage(*message);
     }
     LOG("[Client] Receive loop finished.");
 }
 
-void Client::processIncomingData() {
-    std::lock_guard<std::mutex> lock(bufferMutex);
-    std::string message;
-    while (Protocol::extractMessage(receiveBuffer, message)) {
-        // LOG("[Client] Processing message: %s", message.c_str());
-
-        uint32_t assignedId;
-        if (Protocol::deserializeServerShutdown(message)) {
-            disconnect();
+void Client::processMessage(const std::string& message) {
+    // LOG("[Client] Processing message: %s", message.c_str());
+
+    if (message.empty()) return;
+    uint32_t assignedId;
+    uint64_t receivedUs = ClockSync::nowUs();
+    uint64_t pingSentUs, pingReceivedUs, pongSentUs;
+    switch (static_cast<uint8_t>(message[0])) {
+        case Protocol::SERVER_SHUTDOWN:
+            if (Protocol::deserializeServerShutdown(message)) disconnect();
+            return;
+        case Protocol::PLAYER_JOINED:
+            if (Protocol::deserializePlayerJoined(message, assignedId)) playerId = assignedId;
+            return;
+        case Protocol::LOBBY_JOINED:
+            if (!Protocol::deserializeLobbyJoined(message, assignedId)) return;
+            lobbyId = assignedId;
+            break; // the GUI shows which lobby we are in
+        case Protocol::PONG:
+            if (Protocol::deserializePong(message, pingSentUs, pingReceivedUs, pongSentUs)) {
+                clockSync.addSample(pingSentUs, pingReceivedUs, pongSentUs, receivedUs);
+            }
+            return;
+        case Protocol::PING:
+            // the server measures its own round trip to us
+            if (Protocol::deserializePing(message, pingSentUs)) {
+                sendMessage(Protocol::serializePong(pingSentUs, receivedUs, ClockSync::nowUs()));
+            }
+            return;
+        default:
             break;
-        } else if (Protocol::deserializePlayerJoined(message, assignedId)) {
-            playerId = assignedId;
-        } else {
-          // relay to GUI callback
-          std::lock_guard<std::mutex> lock(callbackMutex);
-          if (messageCallback) {
-              messageCallback(message);
-          }
-        }
+    }
+    // relay to GUI callback
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    if (messageCallback) {
+        messageCallback(message);
     }
 }
 
 void Client::sendMessage(const std::string& message) {
-    if (!isRunning || clientSocket == INVALID_SOCKET) {
+    if (!isRunning || !connection) {
         LOG("[Client] Cannot send message - not connected");
         return;
     }
+    connection->send(makeMessage(message));
+}
+
+void Client::createLobby() {
+    sendMessage(Protocol::serializeCreateLobby());
+}
+
+void Client::joinLobby(uint32_t id) {
+    sendMessage(Protocol::serializeJoinLobby(id));
+}
+
+uint32_t Client::sendPlayerInput(float x, float y) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    uint32_t sequence = ++inputSequence;
+
+    // every packet repeats the last few inputs so a lost one costs nothing
+    inputHistory.push_front({sequence, getClientTick(), x, y});
+    if (inputHistory.size() > Protocol::inputRedundancy) {
+        inputHistory.pop_back();
+    }
+
+    if (simulatedInputLoss > 0 && std::rand() < simulatedInputLoss * RAND_MAX) {
+        return sequence;
+    }
+    std::vector<Protocol::InputSample> samples(inputHistory.begin(), inputHistory.end());
+    sendMessage(Protocol::serializePlayerInput(playerId, samples));
+    return sequence;
+}
 
-    std::string framed = Protocol::frameMessage(message);
-    Protocol::sendRaw(framed.c_str(), clientSocket);
+uint32_t Client::getClientTick() const {
+    auto elapsed = std::chrono::steady_clock::now() - connectTime;
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() * Protocol::clientTickRate / 1000000);
 }
 
-void Client::sendPlayerInput(float x, float y) {
-    std::string message = Protocol::serializePlayerInput(playerId, x, y);
-    sendMessage(message);
+void Client::sendPing() {
+    sendMessage(Protocol::serializePing(ClockSync::nowUs()));
+}
+
+void Client::pingLoop() {
+    auto nextPing = std::chrono::steady_clock::now();
+    while (isRunning) {
+        if (std::chrono::steady_clock::now() >= nextPing) {
+            sendPing();
+            nextPing += std::chrono::milliseconds(pingIntervalMs);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
 }
 
 void Client::setMessageCallback(MessageCallback callback) {
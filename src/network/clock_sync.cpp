@@ -0,0 +1,77 @@
+#include "network/clock_sync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+uint64_t ClockSync::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ClockSync::addSample(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3) {
+    int64_t rtt = static_cast<int64_t>(t3 - t0) - static_cast<int64_t>(t2 - t1);
+    int64_t offset = (static_cast<int64_t>(t1 - t0) + static_cast<int64_t>(t2 - t3)) / 2;
+    if (rtt < 0) rtt = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    samples++;
+
+    // reject round trips far outside the usual spread (a stalled thread or a
+    // retransmit), unless they keep coming, which means the path changed
+    if (samples > windowSize && rtt > smoothedRttUs + 4 * rttVarianceUs + 1000) {
+        if (++consecutiveRejects < 3) {
+            rejected++;
+            return false;
+        }
+    }
+    consecutiveRejects = 0;
+
+    // smoothed RTT and its mean deviation, as in TCP (RFC 6298)
+    if (window.empty()) {
+        smoothedRttUs = static_cast<double>(rtt);
+        rttVarianceUs = rtt / 2.0;
+    } else {
+        rttVarianceUs += (std::abs(smoothedRttUs - rtt) - rttVarianceUs) / 4.0;
+        smoothedRttUs += (rtt - smoothedRttUs) / 8.0;
+    }
+
+    window.push_back({rtt, offset});
+    if (window.size() > windowSize) window.pop_front();
+
+    // NTP clock filter: the sample with the shortest round trip has the
+    // least queueing delay, so its offset is the most trustworthy
+    auto best = std::min_element(window.begin(), window.end(),
+        [](const Sample& a, const Sample& b) { return a.rttUs < b.rttUs; });
+    offsetUs = best->offsetUs;
+    return true;
+}
+
+double ClockSync::getRttMs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return smoothedRttUs / 1000.0;
+}
+
+double ClockSync::getJitterMs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rttVarianceUs / 1000.0;
+}
+
+int64_t ClockSync::getOffsetUs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return offsetUs;
+}
+
+uint64_t ClockSync::remoteNowUs() const {
+    return nowUs() + getOffsetUs();
+}
+
+uint64_t ClockSync::getSampleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples;
+}
+
+uint64_t ClockSync::getRejectedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rejected;
+}
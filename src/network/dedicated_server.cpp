@@ -0,0 +1,97 @@
+#include "network/dedicated_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "network/memory_accounting.h"
+#include "network/profiler.h"
+#include "network/server.h"
+
+namespace {
+std::atomic<bool> running{true};
+
+void signalHandler(int signum) {
+    running = false;
+    printf("\n[Server] Shutdown signal received (%d)\n", signum);
+}
+
+#ifndef _WIN32
+void profilerSignalHandler(int) {
+    Profiler::requestDump();
+}
+#endif
+}
+
+int runDedicatedServer(int argc, char* argv[]) {
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+#ifndef _WIN32
+    // first SIGUSR1 turns the profiler on, later ones write a trace
+    signal(SIGUSR1, profilerSignalHandler);
+#endif
+
+    std::vector<const char*> positional;
+    bool profile = false;
+    unsigned int metricsPort = 0;
+    int tickRate = Server::defaultTicksPerSecond;
+    bool memoryAccounting = false;
+    size_t connectionMemoryCap = 0;
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metricsPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--memory-accounting") == 0) {
+            memoryAccounting = true;
+        } else if (strcmp(argv[i], "--max-connection-kb") == 0 && i + 1 < argc) {
+            // a cap is only enforced while accounting, so it turns accounting on
+            connectionMemoryCap = static_cast<size_t>(std::max(0, atoi(argv[++i]))) * 1024;
+            memoryAccounting = true;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    unsigned int port = 12345;
+    if (positional.size() > 0) port = atoi(positional[0]);
+    uint8_t mapId = 0;
+    if (positional.size() > 1) mapId = static_cast<uint8_t>(atoi(positional[1]));
+    GameMode mode = MODE_CLASSIC;
+    if (positional.size() > 2) mode = static_cast<GameMode>(atoi(positional[2]));
+    Profiler::setEnabled(profile);
+    MemoryAccounting::setEnabled(memoryAccounting);
+
+    Server server(port, mapId, mode, tickRate);
+    server.setConnectionMemoryCap(connectionMemoryCap);
+    if (!server.init()) {
+        printf("Failed to start server on port %d\n", port);
+        return 1;
+    }
+
+    if (metricsPort && !server.startMetrics(metricsPort)) {
+        printf("Failed to serve metrics on port %u\n", metricsPort);
+    }
+
+    printf("Server started on port %d\n", port);
+    printf("Press Ctrl+C to stop\n");
+
+    server.start(false);
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    server.stop();
+    if (Profiler::isEnabled()) {
+        const char* tracePath = "tagpro-trace.json";
+        if (Profiler::writeChromeTrace(tracePath)) printf("Profiler trace written to %s\n", tracePath);
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "network/http_endpoint.h"
+
+namespace {
+// a scraper that hangs up early must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+
+void sendAll(SOCKET socket, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int bytes = send(socket, data.data() + sent, static_cast<int>(data.size() - sent), sendFlags);
+        if (bytes <= 0) return;
+        sent += bytes;
+    }
+}
+}
+
+HttpEndpoint::~HttpEndpoint() {
+    stop();
+}
+
+bool HttpEndpoint::start(unsigned int port, Handler newHandler) {
+    if (running) return false;
+    handler = std::move(newHandler);
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket == INVALID_SOCKET) {
+        LOG_WARN("[Server] Could not create the metrics socket");
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+
+    // loopback only: the endpoint has no authentication
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(listenSocket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(listenSocket, 16) == SOCKET_ERROR) {
+        LOG_WARN("[Server] Could not listen for metrics on 127.0.0.1:%u", port);
+        closeSocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+        return false;
+    }
+
+    running = true;
+    thread = std::thread(&HttpEndpoint::serve, this);
+    LOG("[Server] Serving metrics on http://127.0.0.1:%u/metrics", port);
+    return true;
+}
+
+void HttpEndpoint::stop() {
+    if (!running.exchange(false)) return;
+    if (thread.joinable()) thread.join();
+    closeSocket(listenSocket);
+    listenSocket = INVALID_SOCKET;
+}
+
+void HttpEndpoint::serve() {
+    while (running) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(listenSocket, &readfds);
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 200 * 1000; // how quickly stop() is noticed
+
+        int activity = select(listenSocket + 1, &readfds, nullptr, nullptr, &timeout);
+        if (activity <= 0) continue;
+
+        SOCKET client = accept(listenSocket, nullptr, nullptr);
+        if (client == INVALID_SOCKET) continue;
+        answer(client);
+        shutdownSocket(client);
+        closeSocket(client);
+    }
+}
+
+void HttpEndpoint::answer(SOCKET client) {
+#ifdef _WIN32
+    DWORD timeout = requestTimeoutMs;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = requestTimeoutMs / 1000;
+    timeout.tv_usec = (requestTimeoutMs % 1000) * 1000;
+#endif
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout));
+
+    // only the request line matters; read until the headers end
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < maxRequestBytes) {
+        char buffer[1024];
+        int bytes = recv(client, buffer, sizeof(buffer), 0);
+        if (bytes <= 0) break;
+        request.append(buffer, bytes);
+    }
+
+    std::string status = "200 OK";
+    std::string body, contentType = "text/plain; charset=utf-8";
+    size_t methodEnd = request.find(' ');
+    size_t pathEnd = methodEnd == std::string::npos ? std::string::npos : request.find(' ', methodEnd + 1);
+    if (pathEnd == std::string::npos) {
+        status = "400 Bad Request";
+        body = "bad request\n";
+    } else if (request.compare(0, methodEnd, "GET") != 0) {
+        status = "405 Method Not Allowed";
+        body = "only GET is supported\n";
+    } else {
+        std::string path = request.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+        path = path.substr(0, path.find('?'));
+        if (!handler(path, body, contentType)) {
+            status = "404 Not Found";
+            body = "not found\n";
+            contentType = "text/plain; charset=utf-8";
+        }
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+                           "Content-Type: " + contentType + "\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+    sendAll(client, response);
+}
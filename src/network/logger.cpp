@@ -0,0 +1,277 @@
+#include "network/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+const char* levelPrefix(LogLevel level) {
+    switch (level) {
+    case LOG_LEVEL_DEBUG: return "debug: ";
+    case LOG_LEVEL_WARN: return "warning: ";
+    case LOG_LEVEL_ERROR: return "error: ";
+    default: return "";
+    }
+}
+
+template <typename... Args>
+void appendFormatted(std::string& out, const char* spec, Args... args) {
+    char buffer[256];
+    int length = std::snprintf(buffer, sizeof(buffer), spec, args...);
+    if (length < 0) return;
+    if (static_cast<size_t>(length) < sizeof(buffer)) {
+        out.append(buffer, length);
+    } else {
+        size_t start = out.size();
+        out.resize(start + length + 1);
+        std::snprintf(&out[start], length + 1, spec, args...);
+        out.resize(start + length);
+    }
+}
+}
+
+void LogArgWriter::putString(const char* value) {
+    if (!value) value = "(null)";
+    // tag, a 16-bit length, then the bytes and their terminator
+    if (record.size + 4u > LogRecord::argBytes) return;
+    size_t room = LogRecord::argBytes - record.size - 4;
+    uint16_t length = static_cast<uint16_t>(std::min(std::strlen(value), room));
+    record.args[record.size++] = static_cast<char>(LogRecord::ARG_STRING);
+    std::memcpy(record.args + record.size, &length, sizeof(length));
+    record.size += sizeof(length);
+    std::memcpy(record.args + record.size, value, length);
+    record.size += length;
+    record.args[record.size++] = '\0';
+}
+
+Logger::Logger() {
+    flusher = std::thread(&Logger::flushLoop, this);
+}
+
+Logger* Logger::create() {
+    Logger* logger = new Logger();
+    std::atexit(shutdownAtExit);
+    return logger;
+}
+
+void Logger::shutdownAtExit() {
+    // write out what is queued; later calls are written synchronously
+    Logger& logger = instance();
+    {
+        std::lock_guard<std::mutex> lock(logger.flushMutex);
+        logger.stopping = true;
+    }
+    logger.flushWake.notify_all();
+    logger.flusher.join();
+    logger.stopped = true;
+    logger.drainAndWrite(); // anything that raced with the last pass
+}
+
+Logger::ThreadBuffer* Logger::localBuffer() {
+    // registered on the thread's first call; when the thread exits the
+    // flusher drops the buffer once it is empty
+    struct Handle {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~Handle() {
+            if (buffer) buffer->abandoned.store(true, std::memory_order_release);
+        }
+    };
+    thread_local Handle handle;
+    if (!handle.buffer) {
+        handle.buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(handle.buffer);
+    }
+    return handle.buffer.get();
+}
+
+void Logger::submit(const LogRecord& record) {
+    if (stopped.load(std::memory_order_acquire)) {
+        writeLine(record);
+        return;
+    }
+    SpscQueue<LogRecord>& queue = localBuffer()->queue;
+    if (!queue.push(record)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (queue.size() > recordsPerThread / 2 && !wakeRequested.exchange(true, std::memory_order_relaxed)) {
+        flushWake.notify_one();
+    }
+}
+
+void Logger::flush() {
+    if (stopped) return;
+    std::unique_lock<std::mutex> lock(flushMutex);
+    uint64_t ticket = ++flushRequested;
+    flushWake.notify_all();
+    flushDone.wait(lock, [this, ticket] { return flushCompleted >= ticket || stopping; });
+}
+
+size_t Logger::getBufferBytes() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    size_t bytes = 0;
+    for (const auto& buffer : buffers) bytes += sizeof(ThreadBuffer) + buffer->queue.capacity() * sizeof(LogRecord);
+    return bytes;
+}
+
+void Logger::setOutput(FILE* out) {
+    flush();
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output = out;
+}
+
+void Logger::flushLoop() {
+    std::unique_lock<std::mutex> lock(flushMutex);
+    while (true) {
+        flushWake.wait_for(lock, std::chrono::milliseconds(flushIntervalMs),
+                           [this] { return stopping || flushRequested > flushCompleted || wakeRequested; });
+        wakeRequested = false;
+        bool last = stopping;
+        // records pushed before a flush() call are in the rings by now
+        uint64_t ticket = flushRequested;
+        lock.unlock();
+        drainAndWrite();
+        lock.lock();
+        flushCompleted = ticket;
+        flushDone.notify_all();
+        if (last) return;
+    }
+}
+
+void Logger::drainAndWrite() {
+    std::vector<std::shared_ptr<ThreadBuffer>> current;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        current = buffers;
+    }
+
+    std::vector<LogRecord> batch;
+    for (auto& buffer : current) {
+        LogRecord record;
+        while (buffer->queue.pop(record)) batch.push_back(record);
+    }
+    // threads only order their own records; merge by time
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const LogRecord& a, const LogRecord& b) { return a.timeNs < b.timeNs; });
+
+    std::string text;
+    for (const LogRecord& record : batch) {
+        format(record, text);
+        text += '\n';
+    }
+    uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+    if (droppedNow != droppedReported) {
+        appendFormatted(text, "[Log] %llu messages dropped, the log buffers were full\n",
+                        static_cast<unsigned long long>(droppedNow - droppedReported));
+        droppedReported = droppedNow;
+    }
+    if (!text.empty()) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fwrite(text.data(), 1, text.size(), output);
+        std::fflush(output);
+    }
+
+    // buffers of exited threads go once they are empty
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                 [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                                     return buffer->abandoned.load(std::memory_order_acquire) &&
+                                            buffer->queue.empty();
+                                 }),
+                  buffers.end());
+}
+
+void Logger::writeLine(const LogRecord& record) {
+    std::string text;
+    format(record, text);
+    text += '\n';
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::fwrite(text.data(), 1, text.size(), output);
+    std::fflush(output);
+}
+
+void Logger::format(const LogRecord& record, std::string& out) {
+    out += levelPrefix(record.site->level);
+
+    size_t offset = 0;
+    auto next = [&record, &offset](LogRecord::ArgType& type) -> const char* {
+        if (offset >= record.size) return nullptr;
+        type = static_cast<LogRecord::ArgType>(record.args[offset]);
+        const char* value = record.args + offset + 1;
+        uint16_t length = 0;
+        if (type == LogRecord::ARG_STRING) std::memcpy(&length, value, sizeof(length));
+        offset += 1 + (type == LogRecord::ARG_STRING ? sizeof(length) + length + 1 : sizeof(uint64_t));
+        return value;
+    };
+
+    for (const char* p = record.site->format; *p; ++p) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            ++p;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion; the length is
+        // replaced to match how the argument was stored
+        std::string spec = "%";
+        ++p;
+        while (*p && std::strchr("-+ #0", *p)) spec += *p++;
+        while (*p && (std::isdigit(static_cast<unsigned char>(*p)) || *p == '.')) spec += *p++;
+        while (*p && std::strchr("hljztL", *p)) ++p;
+        char conversion = *p;
+        if (!conversion) break;
+
+        LogRecord::ArgType type;
+        const char* value = next(type);
+        if (!value) {
+            out += "<?>";
+            continue;
+        }
+        uint64_t bits;
+        double number;
+        std::memcpy(&bits, value, sizeof(bits));
+        std::memcpy(&number, value, sizeof(number));
+        bool isDouble = type == LogRecord::ARG_DOUBLE;
+        switch (conversion) {
+        case 'd': case 'i':
+            appendFormatted(out, (spec + "lld").c_str(),
+                            isDouble ? static_cast<long long>(number) : static_cast<long long>(bits));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            appendFormatted(out, (spec + "ll" + conversion).c_str(),
+                            isDouble ? static_cast<unsigned long long>(number) : static_cast<unsigned long long>(bits));
+            break;
+        case 'c':
+            appendFormatted(out, (spec + "c").c_str(), static_cast<int>(bits));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (!isDouble) {
+                number = type == LogRecord::ARG_SIGNED ? static_cast<double>(static_cast<int64_t>(bits))
+                                                       : static_cast<double>(bits);
+            }
+            appendFormatted(out, (spec + conversion).c_str(), number);
+            break;
+        case 's':
+            if (type == LogRecord::ARG_STRING) {
+                appendFormatted(out, (spec + "s").c_str(), value + sizeof(uint16_t));
+            } else {
+                out += "<?>";
+            }
+            break;
+        case 'p':
+            appendFormatted(out, "%p", reinterpret_cast<void*>(static_cast<uintptr_t>(bits)));
+            break;
+        default:
+            out += "<?>";
+            break;
+        }
+    }
+
+    if (record.suppressedBefore > 0) {
+        appendFormatted(out, " (%u similar messages suppressed)", record.suppressedBefore);
+    }
+}
@@ -0,0 +1,43 @@
+#include "network/memory_accounting.h"
+
+namespace {
+std::atomic<bool> enabled{false};
+MemoryAccount totals[MEMORY_SUBSYSTEM_COUNT];
+constexpr const char* names[MEMORY_SUBSYSTEM_COUNT] = {"game_state", "client_buffers", "snapshots", "logging"};
+}
+
+void MemoryAccount::set(size_t bytes) {
+    size_t previous = live.exchange(bytes, std::memory_order_relaxed);
+    raisePeak(bytes);
+    if (!parent) return;
+    if (bytes > previous) parent->add(bytes - previous);
+    else if (bytes < previous) parent->remove(previous - bytes);
+}
+
+void MemoryAccount::add(size_t bytes) {
+    raisePeak(live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryAccount::raisePeak(size_t bytes) {
+    size_t high = peak.load(std::memory_order_relaxed);
+    while (bytes > high && !peak.compare_exchange_weak(high, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+namespace MemoryAccounting {
+    void setEnabled(bool on) {
+        enabled.store(on, std::memory_order_relaxed);
+    }
+
+    bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    MemoryAccount& total(MemorySubsystem subsystem) {
+        return totals[subsystem];
+    }
+
+    const char* name(MemorySubsystem subsystem) {
+        return names[subsystem];
+    }
+}
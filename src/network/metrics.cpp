@@ -0,0 +1,288 @@
+#include "network/metrics.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include "network/protocol.h"
+
+namespace {
+struct TypeName {
+    uint8_t type;
+    const char* name;
+};
+
+constexpr TypeName messageTypes[] = {
+    {Protocol::PLAYER_LIST, "player_list"},
+    {Protocol::GAME_STATE, "game_state"},
+    {Protocol::PLAYER_INPUT, "player_input"},
+    {Protocol::REQUEST_PLAYER_LIST, "request_player_list"},
+    {Protocol::PLAYER_JOINED, "player_joined"},
+    {Protocol::PLAYER_LEFT, "player_left"},
+    {Protocol::MARK_CLIENT_HOST, "mark_client_host"},
+    {Protocol::REQUEST_START_GAME, "request_start_game"},
+    {Protocol::PING, "ping"},
+    {Protocol::PONG, "pong"},
+    {Protocol::CREATE_LOBBY, "create_lobby"},
+    {Protocol::JOIN_LOBBY, "join_lobby"},
+    {Protocol::LOBBY_JOINED, "lobby_joined"},
+    {Protocol::GAME_EVENTS, "game_events"},
+    {Protocol::SERVER_SHUTDOWN, "server_shutdown"},
+};
+
+bool isKnownType(size_t type) {
+    for (const TypeName& known : messageTypes) {
+        if (known.type == type) return true;
+    }
+    return false;
+}
+
+void append(std::string& out, const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) out.append(line, std::min<size_t>(length, sizeof(line) - 1));
+}
+
+void appendMemory(std::string& out, const char* name, const MemoryAccount& account) {
+    append(out, "\"%s\":{\"liveBytes\":%zu,\"peakBytes\":%zu}", name, account.getLive(), account.getPeak());
+}
+
+// emit(name, messages, bytes) for every known type, then the rest summed
+// as "unknown" so garbage type bytes cannot grow the label set
+template <typename Emit>
+void forEachType(const MessageTraffic& traffic, Emit emit) {
+    for (const TypeName& known : messageTypes) {
+        emit(known.name, traffic.messages[known.type].load(std::memory_order_relaxed),
+             traffic.bytes[known.type].load(std::memory_order_relaxed));
+    }
+    uint64_t messages = 0, bytes = 0;
+    for (size_t type = 0; type < traffic.messages.size(); ++type) {
+        if (isKnownType(type)) continue;
+        messages += traffic.messages[type].load(std::memory_order_relaxed);
+        bytes += traffic.bytes[type].load(std::memory_order_relaxed);
+    }
+    if (messages) emit("unknown", messages, bytes);
+}
+}
+
+ServerMetrics::ServerMetrics()
+    : startTime(std::chrono::steady_clock::now()), roster(std::make_shared<const Roster>()) {}
+
+void ServerMetrics::recordTick(uint32_t durationUs) {
+    size_t bucket = 0;
+    while (bucket < tickBucketsUs.size() && durationUs > tickBucketsUs[bucket]) ++bucket;
+    tickBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    tickTotalUs.fetch_add(durationUs, std::memory_order_relaxed);
+    tickCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerMetrics::publishRoster(Roster next) {
+    std::atomic_store(&roster, std::shared_ptr<const Roster>(std::make_shared<Roster>(std::move(next))));
+}
+
+std::string ServerMetrics::renderPrometheus(uint64_t tickOverruns) const {
+    std::shared_ptr<const Roster> current = loadRoster();
+    std::string out;
+    out.reserve(8192);
+
+    out += "# HELP tagpro_tick_duration_seconds Time to update and broadcast one lobby tick.\n"
+           "# TYPE tagpro_tick_duration_seconds histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < tickBucketsUs.size(); ++i) {
+        cumulative += tickBuckets[i].load(std::memory_order_relaxed);
+        append(out, "tagpro_tick_duration_seconds_bucket{le=\"%g\"} %llu\n",
+               tickBucketsUs[i] / 1e6, (unsigned long long)cumulative);
+    }
+    cumulative += tickBuckets.back().load(std::memory_order_relaxed);
+    append(out, "tagpro_tick_duration_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+    append(out, "tagpro_tick_duration_seconds_sum %.6f\n", tickTotalUs.load(std::memory_order_relaxed) / 1e6);
+    append(out, "tagpro_tick_duration_seconds_count %llu\n", (unsigned long long)cumulative);
+
+    out += "# HELP tagpro_tick_overruns_total Lobby ticks finished after their deadline or skipped.\n"
+           "# TYPE tagpro_tick_overruns_total counter\n";
+    append(out, "tagpro_tick_overruns_total %llu\n", (unsigned long long)tickOverruns);
+
+    out += "# HELP tagpro_connected_clients Clients connected to the server.\n"
+           "# TYPE tagpro_connected_clients gauge\n";
+    append(out, "tagpro_connected_clients %zu\n", current->clients.size());
+    out += "# HELP tagpro_lobbies Lobbies open on the server.\n"
+           "# TYPE tagpro_lobbies gauge\n";
+    append(out, "tagpro_lobbies %zu\n", current->lobbies.size());
+
+    struct Family {
+        const char* name;
+        const char* help;
+        const MessageTraffic& traffic;
+        bool bytes;
+    };
+    const Family families[] = {
+        {"tagpro_messages_received_total", "Messages received from clients, by type.", received, false},
+        {"tagpro_received_bytes_total", "Payload bytes received from clients, by message type.", received, true},
+        {"tagpro_messages_sent_total", "Messages sent to clients, by type; a broadcast counts once per client.", sent, false},
+        {"tagpro_sent_bytes_total", "Payload bytes sent to clients, by message type.", sent, true},
+        {"tagpro_messages_rate_limited_total", "Messages from clients dropped by their rate limits, by type.",
+         rateLimited, false},
+    };
+    for (const Family& family : families) {
+        append(out, "# HELP %s %s\n# TYPE %s counter\n", family.name, family.help, family.name);
+        forEachType(family.traffic, [&](const char* type, uint64_t messages, uint64_t bytes) {
+            append(out, "%s{type=\"%s\"} %llu\n", family.name, type,
+                   (unsigned long long)(family.bytes ? bytes : messages));
+        });
+    }
+
+    out += "# HELP tagpro_input_queue_depth Inputs waiting for the lobby's game when its last tick began.\n"
+           "# TYPE tagpro_input_queue_depth gauge\n";
+    for (const LobbyEntry& lobby : current->lobbies) {
+        append(out, "tagpro_input_queue_depth{lobby=\"%u\"} %u\n", lobby.lobbyId,
+               lobby.gauges->inputQueueDepth.load(std::memory_order_relaxed));
+    }
+    out += "# HELP tagpro_lobby_players Players in the lobby.\n"
+           "# TYPE tagpro_lobby_players gauge\n";
+    for (const LobbyEntry& lobby : current->lobbies) {
+        append(out, "tagpro_lobby_players{lobby=\"%u\"} %zu\n", lobby.lobbyId, lobby.players);
+    }
+
+    out += "# HELP tagpro_client_send_queue Messages handed to a client's connection and not yet sent.\n"
+           "# TYPE tagpro_client_send_queue gauge\n";
+    for (const ClientEntry& client : current->clients) {
+        append(out, "tagpro_client_send_queue{lobby=\"%u\",player=\"%u\"} %zu\n",
+               client.lobbyId, client.playerId, client.connection->pendingSends());
+    }
+
+    out += "# HELP tagpro_client_rate_limited_total Messages from the client dropped by its rate limits.\n"
+           "# TYPE tagpro_client_rate_limited_total counter\n";
+    for (const ClientEntry& client : current->clients) {
+        append(out, "tagpro_client_rate_limited_total{lobby=\"%u\",player=\"%u\"} %llu\n", client.lobbyId,
+               client.playerId, (unsigned long long)client.gauges->rateLimited.load(std::memory_order_relaxed));
+    }
+    out += "# HELP tagpro_flood_disconnects_total Clients disconnected for exceeding their rate limits persistently.\n"
+           "# TYPE tagpro_flood_disconnects_total counter\n";
+    append(out, "tagpro_flood_disconnects_total %llu\n",
+           (unsigned long long)floodDisconnects.load(std::memory_order_relaxed));
+    out += "# HELP tagpro_player_list_coalesced_total Player list requests answered by a reply already due that tick.\n"
+           "# TYPE tagpro_player_list_coalesced_total counter\n";
+    append(out, "tagpro_player_list_coalesced_total %llu\n",
+           (unsigned long long)playerListsCoalesced.load(std::memory_order_relaxed));
+
+    out += "# HELP tagpro_memory_cap_disconnects_total Connections closed for holding more than the memory cap.\n"
+           "# TYPE tagpro_memory_cap_disconnects_total counter\n";
+    append(out, "tagpro_memory_cap_disconnects_total %llu\n",
+           (unsigned long long)memoryCapDisconnects.load(std::memory_order_relaxed));
+    if (!MemoryAccounting::isEnabled()) return out;
+
+    // live and high-water bytes, from the process totals down to each lobby and client
+    for (bool peak : {false, true}) {
+        const char* family = peak ? "tagpro_memory_peak_bytes" : "tagpro_memory_bytes";
+        append(out, "# HELP %s %s bytes by subsystem.\n# TYPE %s gauge\n", family,
+               peak ? "High-water" : "Live", family);
+        for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; ++subsystem) {
+            const MemoryAccount& total = MemoryAccounting::total(static_cast<MemorySubsystem>(subsystem));
+            append(out, "%s{subsystem=\"%s\"} %zu\n", family,
+                   MemoryAccounting::name(static_cast<MemorySubsystem>(subsystem)),
+                   peak ? total.getPeak() : total.getLive());
+        }
+    }
+    for (bool peak : {false, true}) {
+        const char* family = peak ? "tagpro_lobby_memory_peak_bytes" : "tagpro_lobby_memory_bytes";
+        append(out, "# HELP %s %s bytes of the lobby's game state and snapshot.\n# TYPE %s gauge\n", family,
+               peak ? "High-water" : "Live", family);
+        for (const LobbyEntry& lobby : current->lobbies) {
+            const MemoryAccount& game = lobby.gauges->gameMemory;
+            const MemoryAccount& snapshot = lobby.gauges->snapshotMemory;
+            append(out, "%s{lobby=\"%u\",subsystem=\"game_state\"} %zu\n", family, lobby.lobbyId,
+                   peak ? game.getPeak() : game.getLive());
+            append(out, "%s{lobby=\"%u\",subsystem=\"snapshots\"} %zu\n", family, lobby.lobbyId,
+                   peak ? snapshot.getPeak() : snapshot.getLive());
+        }
+    }
+    for (bool peak : {false, true}) {
+        const char* family = peak ? "tagpro_client_memory_peak_bytes" : "tagpro_client_memory_bytes";
+        append(out, "# HELP %s %s bytes of the client's connection buffers.\n# TYPE %s gauge\n", family,
+               peak ? "High-water" : "Live", family);
+        for (const ClientEntry& client : current->clients) {
+            const MemoryAccount& memory = client.connection->memory;
+            append(out, "%s{lobby=\"%u\",player=\"%u\"} %zu\n", family, client.lobbyId, client.playerId,
+                   peak ? memory.getPeak() : memory.getLive());
+        }
+    }
+    return out;
+}
+
+std::string ServerMetrics::renderJson(uint64_t tickOverruns) const {
+    std::shared_ptr<const Roster> current = loadRoster();
+    auto uptime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - startTime);
+    uint64_t ticks = tickCount.load(std::memory_order_relaxed);
+    uint64_t totalUs = tickTotalUs.load(std::memory_order_relaxed);
+
+    bool accounting = MemoryAccounting::isEnabled();
+    std::string out;
+    out.reserve(4096);
+    append(out, "{\"uptimeSec\":%lld,\"ticks\":{\"count\":%llu,\"overruns\":%llu,\"meanUs\":%.1f},",
+           (long long)uptime.count(), (unsigned long long)ticks, (unsigned long long)tickOverruns,
+           ticks ? static_cast<double>(totalUs) / ticks : 0.0);
+
+    out += "\"lobbies\":[";
+    for (size_t i = 0; i < current->lobbies.size(); ++i) {
+        const LobbyEntry& lobby = current->lobbies[i];
+        append(out, "%s{\"id\":%u,\"players\":%zu,\"gameRunning\":%s,\"inputQueueDepth\":%u,\"lastTickUs\":%u",
+               i ? "," : "", lobby.lobbyId, lobby.players, lobby.gameRunning ? "true" : "false",
+               lobby.gauges->inputQueueDepth.load(std::memory_order_relaxed),
+               lobby.gauges->lastTickUs.load(std::memory_order_relaxed));
+        if (accounting) {
+            out += ",\"memory\":{";
+            appendMemory(out, "gameState", lobby.gauges->gameMemory);
+            out += ',';
+            appendMemory(out, "snapshots", lobby.gauges->snapshotMemory);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "],\"clients\":[";
+    for (size_t i = 0; i < current->clients.size(); ++i) {
+        const ClientEntry& client = current->clients[i];
+        append(out, "%s{\"lobby\":%u,\"player\":%u,\"ip\":\"%s\",\"sendQueue\":%zu,"
+                    "\"bytesSent\":%llu,\"bytesReceived\":%llu,\"rateLimited\":%llu",
+               i ? "," : "", client.lobbyId, client.playerId, client.ip.c_str(),
+               client.connection->pendingSends(),
+               (unsigned long long)client.connection->getBytesSent(),
+               (unsigned long long)client.connection->getBytesReceived(),
+               (unsigned long long)client.gauges->rateLimited.load(std::memory_order_relaxed));
+        if (accounting) {
+            out += ',';
+            appendMemory(out, "memory", client.connection->memory);
+        }
+        out += '}';
+    }
+    out += "],\"messages\":{";
+    const std::pair<const char*, const MessageTraffic*> directions[] = {
+        {"received", &received}, {"sent", &sent}, {"rateLimited", &rateLimited}};
+    for (size_t d = 0; d < 3; ++d) {
+        append(out, "%s\"%s\":{", d ? "," : "", directions[d].first);
+        bool first = true;
+        forEachType(*directions[d].second, [&](const char* type, uint64_t messages, uint64_t bytes) {
+            if (!messages) return;
+            append(out, "%s\"%s\":{\"count\":%llu,\"bytes\":%llu}", first ? "" : ",", type,
+                   (unsigned long long)messages, (unsigned long long)bytes);
+            first = false;
+        });
+        out += "}";
+    }
+    append(out, "},\"flood\":{\"disconnects\":%llu,\"playerListsCoalesced\":%llu}",
+           (unsigned long long)floodDisconnects.load(std::memory_order_relaxed),
+           (unsigned long long)playerListsCoalesced.load(std::memory_order_relaxed));
+    if (accounting) {
+        out += ",\"memory\":{";
+        for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; ++subsystem) {
+            if (subsystem) out += ',';
+            appendMemory(out, MemoryAccounting::name(static_cast<MemorySubsystem>(subsystem)),
+                         MemoryAccounting::total(static_cast<MemorySubsystem>(subsystem)));
+        }
+        append(out, ",\"capDisconnects\":%llu}",
+               (unsigned long long)memoryCapDisconnects.load(std::memory_order_relaxed));
+    }
+    out += "}\n";
+    return out;
+}
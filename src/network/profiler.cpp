@@ -0,0 +1,199 @@
+#include "network/profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace {
+// one closed zone; fields are atomics so a dump can read a ring while its
+// thread keeps writing (torn entries are detected and skipped)
+struct Event {
+    std::atomic<uint64_t> startNs{0};
+    std::atomic<uint64_t> packed{0}; // zone << 48 | duration in ns
+};
+constexpr uint64_t durationMask = (uint64_t(1) << 48) - 1;
+
+struct ThreadState {
+    explicit ThreadState(uint32_t index) : index(index), events(Profiler::eventsPerThread) {}
+
+    uint32_t index; // trace "tid"
+    std::vector<Event> events;
+    std::atomic<uint64_t> written{0};
+    std::array<std::array<std::atomic<uint64_t>, ZoneHistogram::bucketCount>, Profiler::maxZones> buckets{};
+    std::array<std::atomic<uint64_t>, Profiler::maxZones> totalNs{};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> zoneNames;
+    std::vector<std::shared_ptr<ThreadState>> threads;
+    std::atomic<uint64_t> epochNs{0}; // trace timestamps are relative to this
+
+    // rolling window for getHistograms()
+    std::mutex histogramMutex;
+    uint64_t windowStartNs = 0;
+    std::vector<ZoneHistogram> windowStart, previousWindowStart;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry(); // outlives threads still recording at exit
+    return *instance;
+}
+
+ThreadState& localState() {
+    thread_local std::shared_ptr<ThreadState> state;
+    if (!state) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        state = std::make_shared<ThreadState>(static_cast<uint32_t>(r.threads.size() + 1));
+        r.threads.push_back(state);
+    }
+    return *state;
+}
+
+size_t bucketFor(uint64_t durationNs) {
+    uint64_t us = durationNs / 1000;
+    size_t bucket = 0;
+    while (us > 0 && bucket < ZoneHistogram::bucketCount - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::vector<ZoneHistogram> cumulativeHistograms() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<ZoneHistogram> zones(r.zoneNames.size());
+    for (size_t zone = 0; zone < zones.size(); ++zone) {
+        zones[zone].name = r.zoneNames[zone];
+        for (auto& thread : r.threads) {
+            for (size_t b = 0; b < ZoneHistogram::bucketCount; ++b) {
+                uint64_t n = thread->buckets[zone][b].load(std::memory_order_relaxed);
+                zones[zone].buckets[b] += n;
+                zones[zone].count += n;
+            }
+            zones[zone].totalNs += thread->totalNs[zone].load(std::memory_order_relaxed);
+        }
+    }
+    return zones;
+}
+}
+
+uint64_t ZoneHistogram::percentileUs(double p) const {
+    if (count == 0) return 0;
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(p * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < bucketCount; ++b) {
+        seen += buckets[b];
+        if (seen >= target) return uint64_t(1) << b;
+    }
+    return uint64_t(1) << (bucketCount - 1);
+}
+
+void Profiler::setEnabled(bool on) {
+    if (on) {
+        uint64_t none = 0;
+        registry().epochNs.compare_exchange_strong(none, nowNs());
+    }
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+uint16_t Profiler::registerZone(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto existing = std::find(r.zoneNames.begin(), r.zoneNames.end(), name);
+    if (existing != r.zoneNames.end()) return static_cast<uint16_t>(existing - r.zoneNames.begin());
+    if (r.zoneNames.size() == maxZones - 1) r.zoneNames.push_back("other");
+    if (r.zoneNames.size() >= maxZones) return maxZones - 1; // out of ids: shares "other"
+    r.zoneNames.push_back(name);
+    return static_cast<uint16_t>(r.zoneNames.size() - 1);
+}
+
+void Profiler::record(uint16_t zone, uint64_t startNs, uint64_t endNs) {
+    ThreadState& state = localState();
+    uint64_t duration = endNs > startNs ? endNs - startNs : 0;
+
+    uint64_t position = state.written.load(std::memory_order_relaxed);
+    Event& event = state.events[position % eventsPerThread];
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.packed.store((uint64_t(zone) << 48) | std::min(duration, durationMask), std::memory_order_relaxed);
+    state.written.store(position + 1, std::memory_order_release);
+
+    // only this thread writes these, so plain load + store is enough
+    auto& bucket = state.buckets[zone][bucketFor(duration)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    state.totalNs[zone].store(state.totalNs[zone].load(std::memory_order_relaxed) + duration,
+                              std::memory_order_relaxed);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    Registry& r = registry();
+    std::vector<std::shared_ptr<ThreadState>> threads;
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        threads = r.threads;
+        names = r.zoneNames;
+    }
+    uint64_t epoch = r.epochNs.load();
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (auto& thread : threads) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                     first ? "" : ",\n", thread->index, thread->index);
+        first = false;
+
+        uint64_t end = thread->written.load(std::memory_order_acquire);
+        uint64_t begin = end > eventsPerThread ? end - eventsPerThread : 0;
+        std::vector<std::pair<uint64_t, uint64_t>> copied;
+        copied.reserve(end - begin);
+        for (uint64_t position = begin; position < end; ++position) {
+            const Event& event = thread->events[position % eventsPerThread];
+            copied.emplace_back(event.startNs.load(std::memory_order_relaxed),
+                                event.packed.load(std::memory_order_relaxed));
+        }
+        // entries the thread lapped while we copied (or is writing now) are torn
+        uint64_t after = thread->written.load(std::memory_order_acquire);
+        uint64_t firstValid = after + 1 > eventsPerThread ? after + 1 - eventsPerThread : 0;
+
+        for (uint64_t position = std::max(begin, firstValid); position < end; ++position) {
+            auto [startNs, packed] = copied[position - begin];
+            size_t zone = packed >> 48;
+            if (startNs < epoch || zone >= names.size()) continue;
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         names[zone].c_str(), thread->index,
+                         (startNs - epoch) / 1000.0, (packed & durationMask) / 1000.0);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+std::vector<ZoneHistogram> Profiler::getHistograms() {
+    Registry& r = registry();
+    std::vector<ZoneHistogram> current = cumulativeHistograms();
+
+    std::lock_guard<std::mutex> lock(r.histogramMutex);
+    uint64_t now = nowNs();
+    if (now - r.windowStartNs >= uint64_t(histogramWindowSec) * 1000000000) {
+        r.previousWindowStart = std::move(r.windowStart);
+        r.windowStart = current;
+        r.windowStartNs = now;
+    }
+    // subtract the counts from before the previous window began
+    for (size_t zone = 0; zone < current.size() && zone < r.previousWindowStart.size(); ++zone) {
+        const ZoneHistogram& before = r.previousWindowStart[zone];
+        current[zone].count -= before.count;
+        current[zone].totalNs -= before.totalNs;
+        for (size_t b = 0; b < ZoneHistogram::bucketCount; ++b) {
+            current[zone].buckets[b] -= before.buckets[b];
+        }
+    }
+    return current;
+}
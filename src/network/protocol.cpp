@@ -1,33 +1,67 @@
 #include "network/protocol.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 namespace Protocol {
-    // [xx]lobbyId|mapId|redScore|blueScore|player1;player2;...
-    // each player: id,name,x,y,velocityX,velocityY,team,connected;
+    namespace {
+    // appends value as ostream << would print it
+    template <typename T>
+    void put(std::string& out, T value) {
+      char text[32];
+      if constexpr (std::is_floating_point_v<T>) {
+        int length = std::snprintf(text, sizeof(text), "%g", static_cast<double>(value));
+        out.append(text, std::min<size_t>(length, sizeof(text) - 1));
+      } else {
+        auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+        out.append(text, end - text);
+      }
+    }
+    }
+
+    // [xx]lobbyId|mapId|redScore|blueScore|redFlag|blueFlag|tick|tickDurationUs|player1;player2;...
+    // each player: id,name,x,y,velocityX,velocityY,team,connected,lastInputSeq;
     std::string serializeGameState(const GameState& state) {
-      std::ostringstream ss;
-      ss << static_cast<char>(GAME_STATE);
-      ss << state.lobbyId << '|' << static_cast<int>(state.mapId) << '|'
-         << static_cast<int>(state.redScore) << '|'
-         << static_cast<int>(state.blueScore) << '|';
-      ss << state.redFlag << '|' << state.blueFlag << '|';
+      std::string out;
+      serializeGameState(state, out);
+      return out;
+    }
+
+    void serializeGameState(const GameState& state, std::string& out) {
+      out.clear();
+      out += static_cast<char>(GAME_STATE);
+      put(out, state.lobbyId); out += '|';
+      put(out, static_cast<int>(state.mapId)); out += '|';
+      put(out, static_cast<int>(state.redScore)); out += '|';
+      put(out, static_cast<int>(state.blueScore)); out += '|';
+      put(out, state.redFlag); out += '|';
+      put(out, state.blueFlag); out += '|';
+      put(out, state.tick); out += '|';
+      put(out, state.tickDurationUs); out += '|';
       for (const auto& pair : state.players) {
         const PlayerState& player = pair.second;
-        ss << player.id << ',' << player.name << ',' << player.x << ',' << player.y
-           << ',' << player.velocityX << ',' << player.velocityY << ','
-           << static_cast<int>(player.team) << ',' << player.connected << ';';
+        put(out, player.id); out += ',';
+        out += player.name; out += ',';
+        put(out, player.x); out += ',';
+        put(out, player.y); out += ',';
+        put(out, player.velocityX); out += ',';
+        put(out, player.velocityY); out += ',';
+        put(out, static_cast<int>(player.team)); out += ',';
+        put(out, static_cast<int>(player.connected)); out += ',';
+        put(out, player.lastInputSeq); out += ';';
       }
-      return ss.str();
     }
 
     bool deserializeGameState(const std::string& data, GameState& state) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != GAME_STATE) return false;
       std::istringstream ss(data);
-      char type;
-      ss >> type;
-      if (type != GAME_STATE) return false;
+      ss.ignore(1);
 
       char delim;
       int mapTmp, redTmp, blueTmp;
@@ -36,6 +70,7 @@ namespace Protocol {
       state.redScore = static_cast<uint8_t>(redTmp);
       state.blueScore = static_cast<uint8_t>(blueTmp);
       ss >> state.redFlag >> delim >> state.blueFlag >> delim;
+      ss >> state.tick >> delim >> state.tickDurationUs >> delim;
       std::string playerData;
       while (std::getline(ss, playerData, ';') && !playerData.empty()) {
         std::istringstream playerStream(playerData);
@@ -44,13 +79,47 @@ namespace Protocol {
         std::getline(playerStream, player.name, ',');
         playerStream >> player.x >> delim >> player.y >> delim >>
             player.velocityX >> delim >> player.velocityY >> delim >>
-            player.team >> delim >> player.connected;
+            player.team >> delim >> player.connected >> delim >> player.lastInputSeq;
         player.team -= '0';
         state.players[player.id] = player;
       }
       return true;
     }
 
+    // [xx]lobbyId|event1;event2;...
+    // each event: tick,kind,team,playerId,otherId,x,y;
+    std::string serializeGameEvents(uint32_t lobbyId, const std::vector<GameEvent>& events) {
+      std::ostringstream ss;
+      ss << static_cast<char>(GAME_EVENTS) << lobbyId << '|';
+      for (const GameEvent& event : events) {
+        ss << event.tick << ',' << static_cast<int>(event.kind) << ','
+           << static_cast<int>(event.team) << ',' << event.playerId << ','
+           << event.otherId << ',' << event.x << ',' << event.y << ';';
+      }
+      return ss.str();
+    }
+
+    bool deserializeGameEvents(const std::string& data, uint32_t& lobbyId, std::vector<GameEvent>& events) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != GAME_EVENTS) return false;
+      std::istringstream ss(data.substr(1));
+      char delim;
+      ss >> lobbyId >> delim;
+      if (ss.fail()) return false;
+      std::string eventData;
+      while (std::getline(ss, eventData, ';') && !eventData.empty()) {
+        std::istringstream eventStream(eventData);
+        GameEvent event;
+        int kind, team;
+        eventStream >> event.tick >> delim >> kind >> delim >> team >> delim >> event.playerId >> delim
+                    >> event.otherId >> delim >> event.x >> delim >> event.y;
+        if (eventStream.fail()) return false;
+        event.kind = static_cast<GameEventKind>(kind);
+        event.team = static_cast<uint8_t>(team);
+        events.push_back(event);
+      }
+      return true;
+    }
+
     std::string serializePlayerList(const std::vector<std::string>& players) {
       std::ostringstream ss;
       ss << static_cast<char>(PLAYER_LIST);
@@ -63,10 +132,8 @@ namespace Protocol {
 
     std::vector<std::string> deserializePlayerList(const std::string& data) {
       std::vector<std::string> players;
-      std::istringstream ss(data);
-      char type;
-      ss >> type;
-      if (type != PLAYER_LIST) return players;
+      if (data.empty() || static_cast<uint8_t>(data[0]) != PLAYER_LIST) return players;
+      std::istringstream ss(data.substr(1));
 
       std::string player;
       while (std::getline(ss, player, ',')) {
@@ -75,25 +142,44 @@ namespace Protocol {
       return players;
     }
 
-    // [xx]playerId,inputX,inputY
-    std::string serializePlayerInput(uint32_t playerId, float inputX,
-                                     float inputY) {
+    // [xx]playerId,sequence,clientTick|x:y:dt|x:y:dt...
+    // The first entry is the newest input; entry i has sequence - i and was
+    // sampled dt client ticks before the newest. Axes are sent as hundredths
+    // so an entry usually costs 4-9 bytes.
+    std::string serializePlayerInput(uint32_t playerId,
+                                     const std::vector<InputSample>& samples) {
       std::ostringstream ss;
-      ss << static_cast<char>(PLAYER_INPUT) << playerId << ',' << inputX << ','
-         << inputY;
+      ss << static_cast<char>(PLAYER_INPUT) << playerId;
+      if (samples.empty()) return ss.str();
+
+      const InputSample& newest = samples.front();
+      ss << ',' << newest.sequence << ',' << newest.clientTick;
+      for (const InputSample& sample : samples) {
+        ss << '|' << static_cast<int>(std::lround(sample.inputX * 100)) << ':'
+           << static_cast<int>(std::lround(sample.inputY * 100)) << ':'
+           << newest.clientTick - sample.clientTick;
+      }
       return ss.str();
     }
 
     bool deserializePlayerInput(const std::string& data, uint32_t& playerId,
-                                float& inputX, float& inputY) {
-      std::istringstream ss(data);
-      char type;
-      ss >> type;
-      if (type != PLAYER_INPUT) return false;
+                                std::vector<InputSample>& samples) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != PLAYER_INPUT) return false;
+      std::istringstream ss(data.substr(1));
 
       char delim;
-      ss >> playerId >> delim >> inputX >> delim >> inputY;
-      return true;
+      uint32_t sequence, clientTick;
+      ss >> playerId >> delim >> sequence >> delim >> clientTick;
+      if (ss.fail()) return false;
+
+      samples.clear();
+      int x, y;
+      uint32_t ticksBefore;
+      while (samples.size() <= sequence && ss >> delim >> x >> delim >> y >> delim >> ticksBefore) {
+        samples.push_back({sequence - static_cast<uint32_t>(samples.size()),
+                           clientTick - ticksBefore, x / 100.0f, y / 100.0f});
+      }
+      return !samples.empty();
     }
 
     std::string serializePlayerJoined(uint32_t playerId) {
@@ -103,14 +189,10 @@ namespace Protocol {
     }
 
     bool deserializePlayerJoined(const std::string& data, uint32_t& playerId) {
-      std::istringstream ss(data);
-      char type;
-      ss >> type;
-      if (type != PLAYER_JOINED) return false;
-
-      char delim;
+      if (data.empty() || static_cast<uint8_t>(data[0]) != PLAYER_JOINED) return false;
+      std::istringstream ss(data.substr(1));
       ss >> playerId;
-      return true;
+      return !ss.fail();
     }
 
     std::string serializeServerShutdown() {
@@ -120,33 +202,97 @@ namespace Protocol {
     }
 
     bool deserializeServerShutdown(const std::string& data) {
-      std::istringstream ss(data);
-      int type;
-      ss >> type;
-      if (type != SERVER_SHUTDOWN) return false;
+      // the type byte alone; parsing it as text let a lobby id of 255 match
+      return data.size() == 1 && static_cast<uint8_t>(data[0]) == SERVER_SHUTDOWN;
+    }
 
-      return true;
+    // [xx]timestampUs
+    std::string serializePing(uint64_t timestampUs) {
+      std::ostringstream ss;
+      ss << static_cast<char>(PING) << timestampUs;
+      return ss.str();
+    }
+
+    bool deserializePing(const std::string& data, uint64_t& timestampUs) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != PING) return false;
+      std::istringstream ss(data.substr(1));
+      ss >> timestampUs;
+      return !ss.fail();
+    }
+
+    // [xx]pingSentUs,pingReceivedUs,pongSentUs
+    // the first is on the pinging side's clock, the other two on ours
+    std::string serializePong(uint64_t pingSentUs, uint64_t pingReceivedUs,
+                              uint64_t pongSentUs) {
+      std::ostringstream ss;
+      ss << static_cast<char>(PONG) << pingSentUs << ',' << pingReceivedUs << ','
+         << pongSentUs;
+      return ss.str();
+    }
+
+    bool deserializePong(const std::string& data, uint64_t& pingSentUs,
+                         uint64_t& pingReceivedUs, uint64_t& pongSentUs) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != PONG) return false;
+      std::istringstream ss(data.substr(1));
+      char delim;
+      ss >> pingSentUs >> delim >> pingReceivedUs >> delim >> pongSentUs;
+      return !ss.fail();
+    }
+
+    std::string serializeCreateLobby() {
+      std::ostringstream ss;
+      ss << static_cast<char>(CREATE_LOBBY);
+      return ss.str();
+    }
+
+    // [xx]lobbyId
+    std::string serializeJoinLobby(uint32_t lobbyId) {
+      std::ostringstream ss;
+      ss << static_cast<char>(JOIN_LOBBY) << lobbyId;
+      return ss.str();
+    }
+
+    bool deserializeJoinLobby(const std::string& data, uint32_t& lobbyId) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != JOIN_LOBBY) return false;
+      std::istringstream ss(data.substr(1));
+      ss >> lobbyId;
+      return !ss.fail();
+    }
+
+    // [xx]lobbyId
+    std::string serializeLobbyJoined(uint32_t lobbyId) {
+      std::ostringstream ss;
+      ss << static_cast<char>(LOBBY_JOINED) << lobbyId;
+      return ss.str();
+    }
+
+    bool deserializeLobbyJoined(const std::string& data, uint32_t& lobbyId) {
+      if (data.empty() || static_cast<uint8_t>(data[0]) != LOBBY_JOINED) return false;
+      std::istringstream ss(data.substr(1));
+      ss >> lobbyId;
+      return !ss.fail();
     }
 
     std::string frameMessage(const std::string& data) {
       return std::to_string(data.size()) + ":" + data;
     }
 
-    bool extractMessage(std::string& buffer, std::string& message) {
-      size_t colonPos = buffer.find(':');
-      if (colonPos == std::string::npos) return false;
-
-      try {
-        size_t messageLength = std::stoul(buffer.substr(0, colonPos));
-        if (buffer.length() >= colonPos + 1 + messageLength) {
-          message = buffer.substr(colonPos + 1, messageLength);
-          buffer.erase(0, colonPos + 1 + messageLength);
-          return true;
-        }
-      } catch (const std::exception&) {
-        buffer.clear();
+    FrameStatus extractMessage(std::string& buffer, std::string& message) {
+      // garbage is refused as soon as it shows, not once a colon turns up
+      size_t messageLength = 0, colonPos = 0;
+      for (;; ++colonPos) {
+        if (colonPos == buffer.size()) return FRAME_INCOMPLETE;
+        char c = buffer[colonPos];
+        if (c == ':') break;
+        if (c < '0' || c > '9' || colonPos == maxLengthDigits) return FRAME_MALFORMED;
+        messageLength = messageLength * 10 + (c - '0');
       }
-      return false;
+      if (colonPos == 0 || messageLength > maxMessageBytes) return FRAME_MALFORMED;
+      if (buffer.size() < colonPos + 1 + messageLength) return FRAME_INCOMPLETE;
+
+      message.assign(buffer, colonPos + 1, messageLength);
+      buffer.erase(0, colonPos + 1 + messageLength);
+      return FRAME_READY;
     }
 
     std::string serializeMarkClientHost() {
@@ -169,7 +315,7 @@ namespace Protocol {
         while (totalSent < msgLength) {
             int bytesSent = send(socket, msg + totalSent, msgLength - totalSent, 0);
             if (bytesSent <= 0) {
-                LOG("Failed to send message to socket %d", socket);
+                LOG_WARN("Failed to send message to socket %d", socket);
                 return false;
             }
             totalSent += bytesSent;
@@ -177,4 +323,63 @@ namespace Protocol {
         return totalSent == msgLength;
     }
 
+    size_t sendFramed(const std::string& data, SOCKET socket) {
+        if (socket == INVALID_SOCKET) return 0;
+        // same framing as frameMessage, without copying the payload
+        char header[24];
+        size_t headerLength = std::snprintf(header, sizeof(header), "%zu:", data.size());
+        size_t total = headerLength + data.size();
+        size_t sent = 0;
+        while (sent < total) {
+            // header and payload in one call, so TCP_NODELAY sends them together
+            const char* parts[2] = {header, data.data()};
+            size_t lengths[2] = {headerLength, data.size()};
+            size_t skip = sent, count = 0;
+#ifdef _WIN32
+            WSABUF buffers[2];
+#else
+            iovec buffers[2];
+#endif
+            for (int i = 0; i < 2; ++i) {
+                if (skip >= lengths[i]) {
+                    skip -= lengths[i];
+                    continue;
+                }
+#ifdef _WIN32
+                buffers[count].buf = const_cast<char*>(parts[i] + skip);
+                buffers[count].len = static_cast<ULONG>(lengths[i] - skip);
+#else
+                buffers[count].iov_base = const_cast<char*>(parts[i] + skip);
+                buffers[count].iov_len = lengths[i] - skip;
+#endif
+                ++count;
+                skip = 0;
+            }
+#ifdef _WIN32
+            DWORD bytesSent = 0;
+            if (WSASend(socket, buffers, static_cast<DWORD>(count), &bytesSent, 0, nullptr, nullptr) != 0 ||
+                bytesSent == 0) {
+                LOG_WARN("Failed to send message to socket %d", socket);
+                return 0;
+            }
+#else
+            msghdr message{};
+            message.msg_iov = buffers;
+            message.msg_iovlen = count;
+            // a connection shut down under a sender must fail the send, not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+            ssize_t bytesSent = sendmsg(socket, &message, MSG_NOSIGNAL);
+#else
+            ssize_t bytesSent = sendmsg(socket, &message, 0);
+#endif
+            if (bytesSent <= 0) {
+                LOG_WARN("Failed to send message to socket %d", socket);
+                return 0;
+            }
+#endif
+            sent += bytesSent;
+        }
+        return total;
+    }
+
 } // namespace Protocol
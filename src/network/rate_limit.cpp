@@ -0,0 +1,30 @@
+#include "network/rate_limit.h"
+
+#include "network/protocol.h"
+
+const std::array<FloodGuard::Limit, 7> FloodGuard::limits = {{
+    {Protocol::PLAYER_INPUT, 120, 120},
+    {Protocol::REQUEST_PLAYER_LIST, 4, 8},
+    {Protocol::PING, 5, 10},
+    {Protocol::PONG, 5, 10},
+    {Protocol::REQUEST_START_GAME, 2, 4},
+    {Protocol::CREATE_LOBBY, 2, 4},
+    {Protocol::JOIN_LOBBY, 2, 4},
+}};
+
+const FloodGuard::Limit FloodGuard::otherLimit = {0, 5, 10};
+
+FloodGuard::FloodGuard() {
+    for (size_t i = 0; i < limits.size(); ++i) buckets[i] = TokenBucket(limits[i].ratePerSec, limits[i].burst);
+    buckets[limits.size()] = TokenBucket(otherLimit.ratePerSec, otherLimit.burst);
+}
+
+FloodGuard::Verdict FloodGuard::admit(uint8_t type, TokenBucket::Clock::time_point now) {
+    if (flooding) return DROP; // whatever it sent before the disconnect
+    size_t index = 0;
+    while (index < limits.size() && limits[index].type != type) ++index;
+    if (buckets[index].take(now)) return ADMIT;
+    if (strikes.take(now)) return DROP;
+    flooding = true;
+    return DISCONNECT;
+}
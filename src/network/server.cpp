@@ -1,13 +1,18 @@
 #include "network/server.h"
 
-#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
 #include <mutex>
+#include "network/clock_sync.h"
 #include "network/network.h"
+#include "network/profiler.h"
 #include "network/protocol.h"
 
-Server::Server(unsigned int port) : port(port) {
-    game = std::make_unique<Game>(1);
-    LOG("[Server] instance created on port %d", port);
+Server::Server(unsigned int port, uint8_t mapId, GameMode mode, int tickRate)
+    : port(port), mapId(mapId), mode(mode), tickRate(tickRate),
+      scheduler(workers, std::chrono::microseconds(1000000 / tickRate)) {
+    LOG("[Server] instance created on port %d, %d ticks/s", port, tickRate);
 }
 
 Server::~Server() {
@@ -23,13 +28,13 @@ std::string Server::getClientIP(sockaddr_in* clientAddr) {
 
 bool Server::init() {
     if (!initSockets()) {
-        qErrnoWarning("[Server] Socket initialization failed.\n", 200);
+        LOG_ERROR("[Server] Socket initialization failed: %s", lastSocketError());
         return false;
     }
 
     serverSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket == INVALID_SOCKET) {
-        qErrnoWarning("[Server] Error creating socket.\n", 200);
+        LOG_ERROR("[Server] Error creating socket: %s", lastSocketError());
         cleanupSockets();
         return false;
     }
@@ -37,7 +42,7 @@ bool Server::init() {
     int opt = 1;
     if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR,
           (char*)&opt, sizeof(opt)) == SOCKET_ERROR) {
-        LOG("[Server] Warning: Could not set SO_REUSEADDR");
+        LOG_WARN("[Server] Could not set SO_REUSEADDR");
     }
 
     sockaddr_in serverAddr;
@@ -46,14 +51,14 @@ bool Server::init() {
     serverAddr.sin_port = htons(port);
 
     if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        qErrnoWarning("[Server] Bind failed. Port might be in use.\n", 200);
+        LOG_ERROR("[Server] Bind failed, port %u might be in use: %s", port, lastSocketError());
         closeSocket(serverSocket);
         cleanupSockets();
         return false;
     }
 
     if (listen(serverSocket, SOMAXCONN) == SOCKET_ERROR) {
-        qErrnoWarning("[Server] Listen failed.\n", 200);
+        LOG_ERROR("[Server] Listen failed: %s", lastSocketError());
         closeSocket(serverSocket);
         cleanupSockets();
         return false;
@@ -70,6 +75,7 @@ void Server::start(bool inBackground) {
     }
 
     serverRunning = true;
+    scheduler.start();
     if (inBackground) {
         lobbyThread = std::thread(&Server::listenForClients, this);
     } else {
@@ -77,34 +83,47 @@ void Server::start(bool inBackground) {
     }
 }
 
-void Server::start_game() {
+bool Server::start_game(uint32_t lobbyId) {
   if (!serverRunning) {
     LOG("Start server before running game");
-    return;
+    return false;
   }
-  if (gameRunning) {
-    LOG("[Server] Game already running");
-    return;
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  Lobby* lobby = findLobby(lobbyId);
+  if (!lobby) {
+    LOG("[Server] No lobby %u to start", lobbyId);
+    return false;
   }
-  gameRunning = true;
-  game->start();
-  gameThread = std::thread(&Server::gameLoop, this);
+  if (lobby->gameRunning) {
+    LOG("[Server] Game already running in lobby %u", lobbyId);
+    return false;
+  }
+  lobby->gameRunning = true;
+  publishRoster();
+  lobby->game->start();
+  lobby->tickJob = scheduler.add([this, lobby](uint32_t elapsedMs) {
+    tickLobby(lobby, elapsedMs);
+  });
+  return true;
 }
 
 void Server::stop() {
     if (!serverRunning) return;
+    metricsEndpoint.stop();
     broadcastServerShutdown();
 
     serverRunning = false;
-    gameRunning = false;
-    game->stop();
 
+    std::vector<std::unique_ptr<ClientInfo>> clients;
+    std::unordered_map<uint32_t, std::unique_ptr<Lobby>> stoppedLobbies;
     {
         std::lock_guard<std::mutex> lock(clientsMutex);
         for (auto& client : clientThreads) {
             client->running = false; // signal client handler to exit
         }
     }
+    // waits for every tick in flight; the lobbies' tick jobs go with it
+    scheduler.stop();
 
     if (serverSocket != INVALID_SOCKET) {
       ::shutdownSocket(serverSocket);
@@ -112,42 +131,57 @@ void Server::stop() {
       serverSocket = INVALID_SOCKET;
     }
 
-    if (gameThread.joinable()) gameThread.join();
     if (lobbyThread.joinable()) lobbyThread.join();
 
+    // client handlers take clientsMutex themselves,
+    // so join them without holding it
     {
         std::lock_guard<std::mutex> lock(clientsMutex);
         for (auto& client: clientThreads) {
-          if (client->socket != INVALID_SOCKET) {
-            ::shutdownSocket(client->socket);
-            closeSocket(client->socket);
-            client->socket = INVALID_SOCKET;
-          }
+          client->connection->close();
         }
+        clients.swap(clientThreads);
+        publishRoster();
+    }
+    for (auto& client : clients) {
+      if (client->thread.joinable()) {
+        client->thread.join();
+      }
     }
 
-    // clear all the threads
     {
         std::lock_guard<std::mutex> lock(clientsMutex);
-        int i = 0;
-        for (auto& client : clientThreads) {
-          if (client->thread.joinable()) {
-            client->thread.join();
-          }
-        }
-        clientThreads.clear();
+        stoppedLobbies.swap(lobbies);
+        publishRoster();
+    }
+    for (auto& [id, lobby] : stoppedLobbies) {
+        stopLobbyGame(lobby.get());
     }
 
     cleanupSockets();
-    LOG("[Server] Server has stopped cleanly.")
+    LOG("[Server] Server has stopped cleanly.");
 }
 
 void Server::listenForClients() {
+    auto lastStatsTime = std::chrono::steady_clock::now();
+    uint64_t lastMessagesReceived = messagesReceived;
+    auto lastPingTime = std::chrono::steady_clock::now();
+    auto lastProfileTime = std::chrono::steady_clock::now();
     while (serverRunning) {
         cleanFinishedClientThreads();
+        cleanIdleLobbies();
+        logMessageRate(lastStatsTime, lastMessagesReceived);
+        serviceProfiler(lastProfileTime);
+        if (std::chrono::steady_clock::now() - lastPingTime >= std::chrono::milliseconds(pingIntervalMs)) {
+            pingClients();
+            if (MemoryAccounting::isEnabled()) {
+                MemoryAccounting::total(MEMORY_LOGGING).set(Logger::instance().getBufferBytes());
+            }
+            lastPingTime = std::chrono::steady_clock::now();
+        }
         {
             std::lock_guard<std::mutex> lock(clientsMutex);
-            if (clientThreads.size() >= 8) {
+            if (clientThreads.size() >= maxClients) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(200));
                 continue;
             }
@@ -158,22 +192,24 @@ void Server::listenForClients() {
         FD_ZERO(&readfds);
         FD_SET(serverSocket, &readfds);
 
-        // Set timeout to 1 second
+        // Set timeout to the ping interval so clients get pinged on time
         struct timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
+        timeout.tv_sec = pingIntervalMs / 1000;
+        timeout.tv_usec = (pingIntervalMs % 1000) * 1000;
 
         // Check if the socket has data waiting (readable)
         // first argument is ignored in Windows, but needed for max_fd in Linux
         int activity = select(serverSocket + 1, &readfds, nullptr, nullptr, &timeout);
 
         if (activity < 0) {
+            // a trace dump signal only interrupts the wait
+            if (errno == EINTR && Profiler::isDumpRequested()) continue;
             // LOG("[Server] Select error");
             break; // Exit loop on system error
         }
 
         if (activity == 0) {
-            // Timeout occurred (1 second passed), loop back to check serverRunning
+            // Timeout occurred, loop back to check serverRunning
             continue;
         }
 
@@ -193,31 +229,172 @@ void Server::listenForClients() {
         }
 
         std::string clientIP = getClientIP(&clientAddr);
+        addClient(std::make_shared<TcpConnection>(clientSocket), clientIP);
+    }
+    LOG("[Server] Stopped listening for Clients.");
+}
+
+void Server::logMessageRate(std::chrono::steady_clock::time_point& lastTime, uint64_t& lastCount) {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsedSec = std::chrono::duration_cast<std::chrono::seconds>(now - lastTime).count();
+    if (elapsedSec < 10) return;
+    uint64_t count = messagesReceived;
+    if (count != lastCount) {
+        LOG("[Server] Received %llu client messages in the last %llds (%.1f/s)",
+            (unsigned long long)(count - lastCount), (long long)elapsedSec,
+            (double)(count - lastCount) / elapsedSec);
+    }
+    lastTime = now;
+    lastCount = count;
+}
+
+void Server::serviceProfiler(std::chrono::steady_clock::time_point& lastLogTime) {
+    if (Profiler::takeDumpRequest()) {
+        if (!Profiler::isEnabled()) {
+            Profiler::setEnabled(true);
+            LOG("[Server] Profiling enabled; signal again to write a trace");
+        } else {
+            std::string path = "tagpro-trace-" + std::to_string(std::time(nullptr)) + ".json";
+            if (Profiler::writeChromeTrace(path)) {
+                LOG("[Server] Wrote profiler trace to %s", path.c_str());
+            } else {
+                LOG_WARN("[Server] Could not write profiler trace to %s", path.c_str());
+            }
+        }
+    }
 
-        uint32_t newPlayerId = game->getNextPlayerId();
-        LOG("[Server] New client connected from %s, playerId: %d", clientIP.c_str(), newPlayerId);
+    auto now = std::chrono::steady_clock::now();
+    if (!Profiler::isEnabled() || now - lastLogTime < std::chrono::seconds(Profiler::histogramWindowSec)) return;
+    lastLogTime = now;
+    for (const ZoneHistogram& zone : Profiler::getHistograms()) {
+        if (zone.count == 0) continue;
+        LOG("[Server] %-12s %8llu calls  mean %8.1f us  p50 < %6llu us  p99 < %6llu us",
+            zone.name.c_str(), (unsigned long long)zone.count, zone.totalNs / 1000.0 / zone.count,
+            (unsigned long long)zone.percentileUs(0.50), (unsigned long long)zone.percentileUs(0.99));
+    }
+}
 
-        auto newClient = std::make_unique<ClientInfo>(clientSocket, newPlayerId, clientIP);
-        ClientInfo* clientRaw = newClient.get();
+ClientInfo* Server::addClient(std::shared_ptr<Connection> connection, const std::string& ip) {
+    auto newClient = std::make_unique<ClientInfo>(std::move(connection), ip);
+    ClientInfo* clientRaw = newClient.get();
 
-        {
-            std::lock_guard<std::mutex> lock(clientsMutex);
-            std::string name = "Player" + std::to_string(newPlayerId);
-            game->addPlayer(name, newPlayerId % 2);
+    uint32_t lobbyId;
+    bool isHost;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        // new connections fill the first lobby with room; clients can then
+        // create or join a specific lobby
+        Lobby* lobby = findOpenLobby();
+        if (!lobby) lobby = createLobby();
+        joinLobby(clientRaw, lobby);
+        lobbyId = lobby->id;
+        isHost = lobby->host == clientRaw;
+
+        newClient->thread = std::thread(&Server::handleClient, this, clientRaw);
+        clientThreads.push_back(std::move(newClient));
+        publishRoster();
+    }
+    LOG("[Server] New client connected from %s, lobby %u, playerId: %d",
+        ip.c_str(), lobbyId, clientRaw->playerId);
+
+    sendLobbyWelcome(clientRaw, lobbyId, isHost);
+    broadcastPlayerList(lobbyId);
+    return clientRaw;
+}
+
+std::shared_ptr<Connection> Server::connectLocal() {
+    if (!serverRunning) {
+        LOG("[Server] Start server before connecting locally");
+        return nullptr;
+    }
+    auto [serverEnd, clientEnd] = makeLocalConnectionPair();
+    addClient(serverEnd, "local");
+    return clientEnd;
+}
+
+Lobby* Server::createLobby() {
+    uint32_t id = nextLobbyId++;
+    auto& lobby = lobbies[id];
+    lobby = std::make_unique<Lobby>(id, mapId, mode);
+    lobby->game->setWorkerPool(&workers);
+    LOG("[Server] Created lobby %u (%zu lobbies)", id, lobbies.size());
+    return lobby.get();
+}
+
+Lobby* Server::findOpenLobby() {
+    Lobby* best = nullptr;
+    for (auto& [id, lobby] : lobbies) {
+        if (lobby->gameRunning || lobby->members.size() >= maxPlayersPerLobby) continue;
+        if (!best || lobby->id < best->id) best = lobby.get();
+    }
+    return best;
+}
 
-            newClient->thread = std::thread(&Server::handleClient, this, clientRaw);
-            clientThreads.push_back(std::move(newClient));
+Lobby* Server::findLobby(uint32_t lobbyId) {
+    auto it = lobbies.find(lobbyId);
+    return it != lobbies.end() ? it->second.get() : nullptr;
+}
+
+void Server::joinLobby(ClientInfo* client, Lobby* lobby) {
+    std::string name = "Player" + std::to_string(lobby->game->getNextPlayerId());
+    int32_t nextId = lobby->game->getNextPlayerId();
+    client->playerId = lobby->game->addPlayer(name, nextId % 2);
+    client->lobby = lobby;
+    lobby->members.push_back(client);
+    if (!lobby->host) lobby->host = client;
+}
+
+void Server::leaveLobby(ClientInfo* client) {
+    Lobby* lobby = client->lobby;
+    if (!lobby) return;
+    lobby->game->removePlayer(client->playerId);
+    auto& members = lobby->members;
+    members.erase(std::remove(members.begin(), members.end(), client), members.end());
+    if (lobby->host == client) {
+        // hand the lobby to whoever has been there longest
+        lobby->host = members.empty() ? nullptr : members.front();
+        if (lobby->host) {
+            sendTo(*lobby->host->connection, makeMessage(Protocol::serializeMarkClientHost()));
         }
+    }
+    if (members.empty()) lobby->emptySince = std::chrono::steady_clock::now();
+    client->lobby = nullptr;
+}
 
-        assignPlayerId(clientRaw);
-        if (game->getPlayerCount() == 1) {
-          std::string message = Protocol::serializeMarkClientHost();
-          std::string framed = Protocol::frameMessage(message);
-          Protocol::sendRaw(framed.c_str(), clientRaw->socket);
+void Server::moveClient(ClientInfo* client, uint32_t lobbyId, bool createNew) {
+    uint32_t oldLobbyId = 0, newLobbyId;
+    bool isHost;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        Lobby* target = createNew ? nullptr : findLobby(lobbyId);
+        if (!createNew && (!target || target == client->lobby ||
+                           target->members.size() >= maxPlayersPerLobby)) {
+            // stay put; the reply tells the client where it still is
+            newLobbyId = client->lobby ? client->lobby->id : 0;
+            isHost = client->lobby && client->lobby->host == client;
+            target = nullptr;
+        }
+        if (createNew || target) {
+            if (client->lobby) oldLobbyId = client->lobby->id;
+            leaveLobby(client);
+            if (createNew) target = createLobby();
+            joinLobby(client, target);
+            newLobbyId = target->id;
+            isHost = target->host == client;
+            publishRoster();
         }
-        broadcastPlayerList();
     }
-    LOG("[Server] Stopped listening for Clients.");
+    if (oldLobbyId) broadcastPlayerList(oldLobbyId);
+    sendLobbyWelcome(client, newLobbyId, isHost);
+    broadcastPlayerList(newLobbyId);
+}
+
+void Server::sendLobbyWelcome(ClientInfo* client, uint32_t lobbyId, bool isHost) {
+    sendTo(*client->connection, makeMessage(Protocol::serializePlayerJoined(client->playerId)));
+    sendTo(*client->connection, makeMessage(Protocol::serializeLobbyJoined(lobbyId)));
+    if (isHost) {
+        sendTo(*client->connection, makeMessage(Protocol::serializeMarkClientHost()));
+    }
 }
 
 void Server::cleanFinishedClientThreads() {
@@ -235,142 +412,373 @@ void Server::cleanFinishedClientThreads() {
                 ++it;
             }
         }
+        if (!finishedClients.empty()) publishRoster();
     }
     for (auto& client : finishedClients) {
       if (client->thread.joinable()) client->thread.join();
     }
 }
 
+void Server::cleanIdleLobbies() {
+    std::vector<std::unique_ptr<Lobby>> idle;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = lobbies.begin(); it != lobbies.end();) {
+            Lobby& lobby = *it->second;
+            if (lobby.members.empty() &&
+                now - lobby.emptySince >= std::chrono::seconds(lobbyIdleTimeoutSec)) {
+                idle.push_back(std::move(it->second));
+                it = lobbies.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (!idle.empty()) publishRoster();
+    }
+    // stopped outside the lock: a tick in flight broadcasts through it
+    for (auto& lobby : idle) {
+        stopLobbyGame(lobby.get());
+        LOG("[Server] Tore down idle lobby %u", lobby->id);
+    }
+}
+
 void Server::stopClient(ClientInfo* client) {
     if (!client) return;
-    game->removePlayer(client->playerId);
-    if (client->socket != INVALID_SOCKET) {
-      closeSocket(client->socket);
-      client->socket = INVALID_SOCKET;
+    uint32_t lobbyId = 0;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        if (client->lobby) lobbyId = client->lobby->id;
+        leaveLobby(client);
+        publishRoster();
     }
+    client->connection->close();
     client->running = false;
-    if (serverRunning) broadcastPlayerList();
+    if (serverRunning && lobbyId) broadcastPlayerList(lobbyId);
 }
 
 void Server::handleClient(ClientInfo* client) {
-    char buffer[1024];
     // Loop to keep receiving data until the client disconnects
     while (client->running && serverRunning) {
-        memset(buffer, 0, sizeof(buffer)); // Clear buffer
-
-        int bytesReceived = recv(client->socket, buffer, sizeof(buffer)-1, 0);
-
-        if (bytesReceived <= 0) break; // client disconnected
-
-        buffer[bytesReceived] = '\0';
-        client->receiveBuffer.append(buffer);
+        MessagePtr message = client->connection->receive();
+        if (!message) break; // client disconnected
+        if (!checkConnectionMemory(*client->connection)) break;
 
-        // LOG("[Server] Received from player %d: %s", playerId, buffer);
-
-        std::string message;
-        while (Protocol::extractMessage(client->receiveBuffer, message)) {
-            processClientMessage(message);
-        }
+        // LOG("[Server] Received from player %d: %s", playerId, message->c_str());
+        processClientMessage(client, *message);
     }
 
     LOG("[Server] Client handler exiting for player %d", client->playerId);
     stopClient(client);
 }
 
-void Server::processClientMessage(const std::string& message) {
+void Server::processClientMessage(ClientInfo* client, const std::string& message) {
     if (message.empty()) return;
+    messagesReceived++;
+    metrics.recordReceived(message);
+    if (!admitMessage(client, message)) return;
+    // only this client's thread moves it between lobbies, so its lobby
+    // cannot change or be torn down while we use it here
+    Lobby* lobby = client->lobby;
+    if (!lobby) return;
+
     uint8_t messageType = static_cast<uint8_t>(message[0]);
     switch (messageType) {
         case Protocol::REQUEST_PLAYER_LIST:
-            broadcastPlayerList();
+            requestPlayerList(lobby);
             break;
         case Protocol::PLAYER_INPUT: {
             uint32_t playerId;
-            float inputX, inputY;
-            if (Protocol::deserializePlayerInput(message, playerId, inputX, inputY)) {
-                game->queuePlayerInput(playerId, inputX, inputY);
+            std::vector<Protocol::InputSample> samples;
+            if (Protocol::deserializePlayerInput(message, playerId, samples)) {
+                // oldest first; inputs the game already applied are dropped there.
+                // The id in the message is ignored so clients can only move themselves.
+                // Client ticks are rescaled to our tick rate for the jitter buffer.
+                for (auto it = samples.rbegin(); it != samples.rend(); ++it) {
+                    auto clientTick = static_cast<uint32_t>(
+                        static_cast<uint64_t>(it->clientTick) * tickRate / Protocol::clientTickRate);
+                    lobby->game->queuePlayerInput(client->playerId, it->inputX, it->inputY,
+                                                  it->sequence, clientTick);
+                }
+            }
+            break;
+        }
+        case Protocol::PING: {
+            uint64_t receivedUs = ClockSync::nowUs();
+            uint64_t pingSentUs;
+            if (Protocol::deserializePing(message, pingSentUs)) {
+                sendTo(*client->connection, makeMessage(
+                    Protocol::serializePong(pingSentUs, receivedUs, ClockSync::nowUs())));
+            }
+            break;
+        }
+        case Protocol::PONG: {
+            uint64_t receivedUs = ClockSync::nowUs();
+            uint64_t pingSentUs, pingReceivedUs, pongSentUs;
+            if (Protocol::deserializePong(message, pingSentUs, pingReceivedUs, pongSentUs)) {
+                client->clockSync.addSample(pingSentUs, pingReceivedUs, pongSentUs, receivedUs);
             }
             break;
+        }
         case Protocol::REQUEST_START_GAME: {
-              start_game();
-              break;
+            bool isHost;
+            {
+                std::lock_guard<std::mutex> lock(clientsMutex);
+                isHost = lobby->host == client;
             }
-        default:
-            LOG("[Server] Unknown message from client: %s", message.c_str());
+            if (isHost) start_game(lobby->id);
             break;
         }
+        case Protocol::CREATE_LOBBY:
+            moveClient(client, 0, true);
+            break;
+        case Protocol::JOIN_LOBBY: {
+            uint32_t lobbyId;
+            if (Protocol::deserializeJoinLobby(message, lobbyId)) {
+                moveClient(client, lobbyId, false);
+            }
+            break;
+        }
+        default:
+            LOG_WARN("[Server] Unknown message from client: %s", message.c_str());
+            break;
     }
 }
 
-void Server::gameLoop() {
-    const int UPDATE_INTERVAL_MS = 1000 / 60; // 60 FPS
-    auto previousTime = std::chrono::steady_clock::now();
+bool Server::admitMessage(ClientInfo* client, const std::string& message) {
+    auto verdict = client->floodGuard.admit(static_cast<uint8_t>(message[0]), std::chrono::steady_clock::now());
+    if (verdict == FloodGuard::ADMIT) return true;
+    metrics.recordRateLimited(message);
+    client->gauges->rateLimited.fetch_add(1, std::memory_order_relaxed);
+    if (verdict == FloodGuard::DISCONNECT) {
+        // its own thread sees the closed connection and cleans up
+        LOG_WARN("[Server] Player %u from %s keeps exceeding its message limits; disconnecting it",
+                 client->playerId, client->clientIP.c_str());
+        metrics.recordFloodDisconnect();
+        client->connection->close();
+    }
+    return false;
+}
+
+void Server::requestPlayerList(Lobby* lobby) {
+    // each reply goes to every member, so while the game ticks, requests
+    // are folded into one list per tick
+    if (lobby->gameRunning) {
+        if (lobby->playerListRequested.exchange(true)) metrics.recordPlayerListCoalesced();
+        return;
+    }
+    broadcastPlayerList(lobby->id);
+}
 
-    while (gameRunning && serverRunning) {
-        auto currentTime = std::chrono::steady_clock::now();
-        auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - previousTime).count();
+void Server::tickLobby(Lobby* lobby, uint32_t elapsedMs) {
+    auto start = std::chrono::steady_clock::now();
+    lobby->gauges->inputQueueDepth.store(static_cast<uint32_t>(lobby->game->getInputQueueDepth()),
+                                         std::memory_order_relaxed);
+    {
+        PROFILE_ZONE("update");
+        lobby->game->update(elapsedMs);
+    }
+    broadcastGameState(lobby);
+    if (lobby->playerListRequested.exchange(false) && serverRunning) broadcastPlayerList(lobby->id);
+    if (MemoryAccounting::isEnabled()) {
+        lobby->gauges->gameMemory.set(lobby->game->getMemoryUsage());
+        lobby->gauges->snapshotMemory.set(lobby->snapshot ? lobby->snapshot->capacity() : 0);
+    }
 
-        if (elapsedTime >= UPDATE_INTERVAL_MS) {
-            game->update(static_cast<uint32_t>(elapsedTime));
-            broadcastGameState();
-            previousTime = currentTime;
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // only this lobby's tick reads its events, so no lock is needed
+    const std::vector<GameEvent>& events = lobby->game->getTickEvents();
+    if (!events.empty()) {
+        PROFILE_ZONE("events");
+        eventSink.submit(lobby->id, events);
+        if (serverRunning) {
+            notifyLobby(lobby->id, makeMessage(Protocol::serializeGameEvents(lobby->id, events)), nullptr,
+                        lobby->game->getTickMemory());
         }
     }
-    LOG("[Server] Game Loop ended");
+
+    auto tickUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    lobby->gauges->lastTickUs.store(tickUs, std::memory_order_relaxed);
+    metrics.recordTick(tickUs);
 }
 
-void Server::broadcastServerShutdown() {
-    if (!serverRunning) return;
-    std::string message = Protocol::serializeServerShutdown();
-    std::string framed = Protocol::frameMessage(message);
-    notifyAll(framed.c_str());
+void Server::stopLobbyGame(Lobby* lobby) {
+    // caller does not hold clientsMutex: the last tick may still be broadcasting
+    if (!lobby->gameRunning.exchange(false)) return;
+    scheduler.remove(lobby->tickJob);
+    lobby->game->stop();
+    // a request the last tick did not get to
+    if (lobby->playerListRequested.exchange(false) && serverRunning) broadcastPlayerList(lobby->id);
+    LOG("[Server] Game ended for lobby %u", lobby->id);
+}
+
+void Server::pingClients() {
+    notifyAll(makeMessage(Protocol::serializePing(ClockSync::nowUs())));
+}
+
+size_t Server::getLobbyCount() {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    return lobbies.size();
+}
+
+std::unordered_map<uint32_t, InputBufferStats> Server::getInputBufferStats(uint32_t lobbyId) {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    Lobby* lobby = findLobby(lobbyId);
+    return lobby ? lobby->game->getInputBufferStats() : std::unordered_map<uint32_t, InputBufferStats>();
+}
+
+std::vector<ClientStats> Server::getClientStats() {
+    std::vector<ClientStats> stats;
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (auto& client : clientThreads) {
+        if (!client->running) continue;
+        stats.push_back({client->lobby ? client->lobby->id : 0, client->playerId,
+                         client->clientIP, client->clockSync.getRttMs(), client->connection->memory.getStats(),
+                         client->gauges->rateLimited.load(std::memory_order_relaxed)});
+    }
+    return stats;
 }
 
-void Server::broadcastGameState() {
+std::vector<LobbyStats> Server::getLobbyStats() {
+    std::vector<LobbyStats> stats;
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (auto& [id, lobby] : lobbies) {
+        TickStats ticks = lobby->gameRunning ? scheduler.getStats(lobby->tickJob) : TickStats{};
+        stats.push_back({id, lobby->members.size(), lobby->gameRunning, ticks,
+                         lobby->gauges->gameMemory.getStats(), lobby->gauges->snapshotMemory.getStats()});
+    }
+    return stats;
+}
+
+bool Server::startMetrics(unsigned int metricsPort) {
+    return metricsEndpoint.start(metricsPort, [this](const std::string& path, std::string& body,
+                                                     std::string& contentType) {
+        return serveMetrics(path, body, contentType);
+    });
+}
+
+bool Server::serveMetrics(const std::string& path, std::string& body, std::string& contentType) {
+    if (path == "/metrics") {
+        body = metrics.renderPrometheus(scheduler.getMissedDeadlines());
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+        return true;
+    }
+    if (path == "/status") {
+        body = metrics.renderJson(scheduler.getMissedDeadlines());
+        contentType = "application/json";
+        return true;
+    }
+    return false;
+}
+
+void Server::publishRoster() {
+    ServerMetrics::Roster roster;
+    roster.clients.reserve(clientThreads.size());
+    for (auto& client : clientThreads) {
+        if (!client->running) continue;
+        roster.clients.push_back({client->lobby ? client->lobby->id : 0, client->playerId,
+                                  client->clientIP, client->connection, client->gauges});
+    }
+    roster.lobbies.reserve(lobbies.size());
+    for (auto& [id, lobby] : lobbies) {
+        roster.lobbies.push_back({id, lobby->members.size(), lobby->gameRunning, lobby->gauges});
+    }
+    metrics.publishRoster(std::move(roster));
+}
+
+bool Server::sendTo(Connection& connection, const MessagePtr& message) {
+    if (!checkConnectionMemory(connection, message->size())) return false;
+    metrics.recordSent(*message);
+    return connection.send(message);
+}
+
+bool Server::checkConnectionMemory(Connection& connection, size_t incomingBytes) {
+    if (!MemoryAccounting::isEnabled()) return true;
+    size_t bytes = connection.bufferedBytes();
+    connection.memory.set(bytes);
+    size_t cap = connectionMemoryCap.load(std::memory_order_relaxed);
+    if (cap == 0 || bytes + incomingBytes <= cap) return true;
+    // a peer that stops reading, or sends oversized messages; its own thread
+    // sees the closed connection and cleans up
+    LOG_WARN("[Server] Connection holds %zu bytes, over the cap of %zu; disconnecting it",
+             bytes + incomingBytes, cap);
+    metrics.recordMemoryCapDisconnect();
+    connection.close();
+    return false;
+}
+
+void Server::broadcastServerShutdown() {
     if (!serverRunning) return;
-    GameState state = game->getGameState();
-    std::string message = Protocol::serializeGameState(state);
-    std::string framed = Protocol::frameMessage(message);
-    notifyAll(framed.c_str());
+    notifyAll(makeMessage(Protocol::serializeServerShutdown()));
 }
 
-void Server::broadcastPlayerList() {
+void Server::broadcastGameState(Lobby* lobby) {
     if (!serverRunning) return;
-    std::vector<std::string> playerNames;
-    for (auto& [id, player]: game->getGameState().players) {
-      playerNames.push_back(player.name);
+    PROFILE_ZONE("broadcast");
+    if (!lobby->snapshot || lobby->snapshot.use_count() > 1) {
+        lobby->snapshot = std::make_shared<std::string>(); // a local client has not read the last one yet
+    } else {
+        // the last reader's release of the buffer happens before we write it
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    {
+        // serialized once, straight from the game state, and shared by every connection
+        PROFILE_ZONE("serialize");
+        lobby->game->readState([&](const GameState& state) {
+            Protocol::serializeGameState(state, *lobby->snapshot);
+        });
     }
-    std::string message = Protocol::serializePlayerList(playerNames);
-    std::string framed = Protocol::frameMessage(message);
-    notifyAll(framed.c_str());
+    PROFILE_ZONE("send");
+    notifyLobby(lobby->id, lobby->snapshot, nullptr, lobby->game->getTickMemory());
 }
 
-void Server::assignPlayerId(ClientInfo* client) {
-    if (client->running && client->socket != INVALID_SOCKET) {
-      std::string msg = Protocol::serializePlayerJoined(client->playerId);
-      std::string framed = Protocol::frameMessage(msg);
-      Protocol::sendRaw(framed.c_str(), client->socket);
+void Server::broadcastPlayerList(uint32_t lobbyId) {
+    if (!serverRunning) return;
+    std::vector<std::string> playerNames;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        Lobby* lobby = findLobby(lobbyId);
+        if (!lobby) return;
+        for (auto& [id, player]: lobby->game->getGameState().players) {
+          playerNames.push_back(player.name);
+        }
     }
+    notifyLobby(lobbyId, makeMessage(Protocol::serializePlayerList(playerNames)));
 }
 
-void Server::notifyAll(const char* msg, SOCKET avoid) {
+void Server::notifyAll(const MessagePtr& message, ClientInfo* avoid) {
     if (!serverRunning) return;
-    std::vector<std::pair<SOCKET, std::atomic<bool>*>> sockets;
+    // hold the connections, not the ClientInfo, so a client cleaned up
+    // meanwhile cannot free one under us
+    std::vector<std::shared_ptr<Connection>> connections;
     {
         std::lock_guard<std::mutex> lock(clientsMutex);
         for (auto& client : clientThreads) {
-            if (client->running && client->socket != INVALID_SOCKET && client->socket != avoid) {
-                sockets.push_back({client->socket, &client->running});
+            if (client->running && client.get() != avoid) {
+                connections.push_back(client->connection);
             }
         }
     }
-    for (auto& [sock, running] : sockets) {
-        Protocol::sendRaw(msg, sock);
+    for (auto& connection : connections) {
+        sendTo(*connection, message);
     }
 }
 
-void Server::notifyAllOthers(const char* msg, SOCKET socket) {
-    notifyAll(msg, socket);
+void Server::notifyLobby(uint32_t lobbyId, const MessagePtr& message, ClientInfo* avoid,
+                         std::pmr::memory_resource* scratch) {
+    if (!serverRunning) return;
+    std::pmr::vector<std::shared_ptr<Connection>> connections(scratch);
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        Lobby* lobby = findLobby(lobbyId);
+        if (!lobby) return;
+        for (ClientInfo* client : lobby->members) {
+            if (client->running && client != avoid) {
+                connections.push_back(client->connection);
+            }
+        }
+    }
+    for (auto& connection : connections) {
+        sendTo(*connection, message);
+    }
 }
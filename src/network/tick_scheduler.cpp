@@ -0,0 +1,138 @@
+#include "network/tick_scheduler.h"
+
+#include <vector>
+#include "network/profiler.h"
+
+TickScheduler::TickScheduler(WorkerPool& pool, std::chrono::microseconds interval)
+    : pool(pool), interval(interval) {}
+
+TickScheduler::~TickScheduler() { stop(); }
+
+void TickScheduler::start() {
+    if (running.exchange(true)) return;
+    timerThread = std::thread(&TickScheduler::timerLoop, this);
+}
+
+void TickScheduler::stop() {
+    if (!running.exchange(false)) return;
+    if (timerThread.joinable()) timerThread.join();
+
+    std::vector<uint64_t> jobIds;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        for (auto& [id, job] : jobs) jobIds.push_back(id);
+    }
+    for (uint64_t id : jobIds) remove(id);
+}
+
+uint64_t TickScheduler::add(TickFunction tick) {
+    auto job = std::make_shared<Job>();
+    job->tick = std::move(tick);
+    job->lastTick = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    uint64_t id = nextJobId++;
+    jobs[id] = std::move(job);
+    return id;
+}
+
+void TickScheduler::remove(uint64_t jobId) {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = jobs.find(jobId);
+        if (it == jobs.end()) return;
+        job = std::move(it->second);
+        jobs.erase(it);
+        job->removed = true;
+    }
+    // ticks are claimed under jobsMutex, so none can be handed out for it
+    // now; wait out the one in flight
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idle.wait(lock, [&job] { return !job->busy; });
+}
+
+TickStats TickScheduler::getStats(uint64_t jobId) {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    auto it = jobs.find(jobId);
+    if (it == jobs.end()) return {};
+    const Job& job = *it->second;
+    return {job.ticks, job.missedDeadlines, job.lastLatencyUs};
+}
+
+size_t TickScheduler::getJobCount() {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    return jobs.size();
+}
+
+void TickScheduler::setLatencyObserver(LatencyObserver observer) {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    latencyObserver = std::move(observer);
+}
+
+void TickScheduler::timerLoop() {
+    auto deadline = std::chrono::steady_clock::now() + interval;
+    std::vector<std::shared_ptr<Job>> due;
+    while (running) {
+        std::this_thread::sleep_until(deadline);
+
+        auto observer = std::make_shared<LatencyObserver>();
+        {
+            // claimed while remove() cannot run, so it either sees the
+            // job busy or the job is never handed out
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            due.clear();
+            for (auto& [id, job] : jobs) {
+                if (job->busy.exchange(true)) {
+                    // still working on the previous deadline; skip this one
+                    ++job->missedDeadlines;
+                    ++totalMissedDeadlines;
+                    continue;
+                }
+                due.push_back(job);
+            }
+            *observer = latencyObserver;
+        }
+
+        for (auto& job : due) {
+            pool.submit([this, job, deadline, observer] { runJob(*job, deadline, *observer); });
+        }
+
+        deadline += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (now > deadline + interval) {
+            // the timer itself fell behind (machine suspended, debugger);
+            // drop the backlog instead of ticking in a burst
+            deadline = now + interval;
+        }
+    }
+}
+
+void TickScheduler::runJob(Job& job, std::chrono::steady_clock::time_point deadline,
+                           const LatencyObserver& observer) {
+    // a job removed after it was claimed only releases busy; remove() is waiting for it
+    if (!job.removed) {
+        auto started = std::chrono::steady_clock::now();
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(started - job.lastTick).count();
+        job.lastTick = started;
+        {
+            PROFILE_ZONE("tick");
+            job.tick(static_cast<uint32_t>(elapsedMs));
+        }
+
+        auto latencyUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - deadline).count());
+        job.lastLatencyUs = latencyUs;
+        ++job.ticks;
+        if (latencyUs > interval.count()) {
+            ++job.missedDeadlines;
+            ++totalMissedDeadlines;
+        }
+        if (observer) observer(latencyUs);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        job.busy = false;
+    }
+    idle.notify_all();
+}
@@ -0,0 +1,128 @@
+#include "network/transport.h"
+
+#include <thread>
+#include "network/logger.h"
+#include "network/protocol.h"
+
+TcpConnection::TcpConnection(SOCKET socket) : socket(socket) {
+    // messages are small and latency bound; don't let Nagle hold them back
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (char*)&noDelay, sizeof(noDelay));
+}
+
+TcpConnection::~TcpConnection() {
+    close();
+    closeSocket(socket);
+}
+
+bool TcpConnection::send(const MessagePtr& message) {
+    if (closed) return false;
+    ++sendsInFlight;
+    sendBytesInFlight += message->size();
+    size_t sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = Protocol::sendFramed(*message, socket);
+    }
+    sendBytesInFlight -= message->size();
+    --sendsInFlight;
+    if (sent == 0) return false;
+    bytesSent += sent;
+    return true;
+}
+
+MessagePtr TcpConnection::receive() {
+    std::string message;
+    Protocol::FrameStatus status;
+    while ((status = Protocol::extractMessage(receiveBuffer, message)) == Protocol::FRAME_INCOMPLETE) {
+        char buffer[1024];
+        if (closed) return nullptr;
+        int bytes = recv(socket, buffer, sizeof(buffer), 0);
+        if (bytes <= 0) return nullptr; // peer disconnected or socket closed
+        bytesReceived += bytes;
+        receiveBuffer.append(buffer, bytes);
+        receiveBufferBytes.store(receiveBuffer.capacity(), std::memory_order_relaxed);
+    }
+    if (status == Protocol::FRAME_MALFORMED) {
+        LOG_WARN("Malformed frame on socket %d, closing", static_cast<int>(socket));
+        close();
+        return nullptr;
+    }
+    if (receiveBuffer.empty() && receiveBuffer.capacity() > shrinkAboveBytes) {
+        // one large message should not pin its buffer for the rest of the connection
+        receiveBuffer.shrink_to_fit();
+        receiveBufferBytes.store(receiveBuffer.capacity(), std::memory_order_relaxed);
+    }
+    return makeMessage(std::move(message));
+}
+
+void TcpConnection::close() {
+    // wakes a blocked recv and fails sends; the descriptor stays ours until destruction
+    if (!closed.exchange(true)) shutdownSocket(socket);
+}
+
+bool LocalConnection::send(const MessagePtr& message) {
+    LocalChannel& channel = *outbound;
+    {
+        std::lock_guard<std::mutex> lock(channel.sendMutex);
+        channel.queuedBytes += message->size(); // before the receiver can take it
+        while (!channel.queue.push(message)) {
+            // the receiver is behind by a whole ring, wait for it like a full socket buffer
+            if (channel.closed) {
+                channel.queuedBytes -= message->size();
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+    if (channel.closed) return false;
+    bytesSent += message->size();
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (channel.receiverWaiting) {
+        std::lock_guard<std::mutex> lock(channel.waitMutex);
+        channel.ready.notify_one();
+    }
+    return true;
+}
+
+MessagePtr LocalConnection::receive() {
+    LocalChannel& channel = *inbound;
+    MessagePtr message;
+    while (true) {
+        // snapshots arrive every tick, so spin briefly before sleeping
+        for (int i = 0; i < 64; ++i) {
+            if (channel.queue.pop(message)) {
+                channel.queuedBytes -= message->size();
+                bytesReceived += message->size();
+                return message;
+            }
+            if (channel.closed) return nullptr;
+        }
+
+        channel.receiverWaiting = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(channel.waitMutex);
+            channel.ready.wait_for(lock, std::chrono::milliseconds(10), [&channel]() {
+                return !channel.queue.empty() || channel.closed;
+            });
+        }
+        channel.receiverWaiting = false;
+    }
+}
+
+void LocalConnection::close() {
+    for (LocalChannel* channel : {inbound.get(), outbound.get()}) {
+        channel->closed = true;
+        std::lock_guard<std::mutex> lock(channel->waitMutex);
+        channel->ready.notify_all();
+    }
+}
+
+std::pair<std::shared_ptr<Connection>, std::shared_ptr<Connection>> makeLocalConnectionPair() {
+    auto toServer = std::make_shared<LocalChannel>();
+    auto toClient = std::make_shared<LocalChannel>();
+    return {std::make_shared<LocalConnection>(toServer, toClient),  // server end
+            std::make_shared<LocalConnection>(toClient, toServer)}; // client end
+}
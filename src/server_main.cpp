@@ -0,0 +1,8 @@
+#include "network/dedicated_server.h"
+
+// tagpro_server: the dedicated server without the GUI or Qt.
+// usage: tagpro_server [PORT] [MAP] [MODE] [--profile] [--metrics-port PORT] [--tick-rate HZ]
+//                      [--memory-accounting] [--max-connection-kb KB]
+int main(int argc, char* argv[]) {
+  return runDedicatedServer(argc - 1, argv + 1);
+}
@@ -18,7 +18,7 @@ The primary components that may require testing:
 - *Network Layer* (`server.cpp`, `client.cpp`, `protocol.h`) - Multiplayer synchronization
 - *GUI Components* (`game_screen.cpp`, `start_screen.cpp`) - User interface and rendering
 
-It's difficult to test this type of application due to the multiplayer aspect, without multiple computers and people, though we can still do some tests despite this. Though, most of it is done through manual testing.
+It's difficult to test this type of application due to the multiplayer aspect, without multiple computers and people, though we can still do some tests despite this. Though, most of it is done through manual testing. For load, `tagpro_loadgen` stands in for the other players: it runs hundreds of headless bot clients from one machine (see Test Case 9).
 
 == Test Environment
 
@@ -41,16 +41,44 @@ It's difficult to test this type of application due to the multiplayer aspect, w
 - Flag graphic follows capturing player
 - Score increments when flag returned
 - Flag resets to base after score or player death
+- A tagged player moves again straight from their base. With a respawn delay (for example `tagpro_batch --set respawnDelayMs=3000`) they are held there that long, the same at 30, 60 and 120 Hz, and the timer is cancelled if the player leaves
+- In the Single Flag mode the blue team cannot pick up the red flag; red scores by bringing the blue flag to the red base
+- Every pickup, capture and pop shows in the kill feed of each client in the lobby, with the tagger named for pops, and is logged by the server as `[GAME] Lobby N tick T: ...`
 
 #image("imgs/carrying-flag.png", width: 90%)
 #image("imgs/score-incremented.png", width: 90%)
 
+=== Test Case 2: Fast Crossings
+Collisions are swept over each step: players meet where their paths first touch, flags are picked up if a player's path passes within reach, and walls bounce a player at the point of contact. The outcome of each scenario below must be the same when the game is stepped at 30, 60 and 120 Hz (`Game::update` with 33, 16 and 8 ms). Place the players by writing their position and velocity through `Game::getPlayerState` after `start()`, with no inputs, and compare the state after 600 ms.
+
+#table(
+  columns: (auto, 1fr, 1fr),
+  [*Scenario*], [*Setup*], [*Expected at every tick rate*],
+  [Head-on], [Red at (330, 300) moving +1000 px/s, blue at (470, 300) moving -1000 px/s], [They bounce off each other; red ends on the left moving left, blue on the right moving right],
+  [Head-on tag], [As above, blue carrying the red flag], [Blue is popped back to its spawn and the red flag is returned],
+  [Glancing], [Red at (330, 290) moving +1000 px/s, blue at (470, 310) moving -1000 px/s], [They deflect and pass each other with identical final velocities (about ±330 px/s)],
+  [Flag fly-by], [Red at (560, 325) moving +1000 px/s, passing 25 px from the blue flag], [Red picks up the blue flag],
+  [Wall], [Red at (700, 150) moving +1000 px/s], [Red bounces off the right wall and moves left at 15% of its speed],
+  [Overtake], [Red at (300, 300) moving +1000 px/s, blue at (340, 300) moving +100 px/s], [Red hits blue from behind; both end up moving right with the same velocities],
+  [Blocked short of the flag], [Red at (625, 300) moving +1000 px/s, blue standing at (660, 305)], [Red bounces off blue and never takes the blue flag, also at 20 Hz (50 ms)],
+  [Thin wall], [Map 1 (`maps/1.tpmap`), red at (144, 220) moving +1000 px/s towards the 40 px pillar at x 160 to 200; also stepped at 20 Hz (50 ms)], [Red never passes x = 145, bounces off the pillar's near face and ends near (55, 220) moving left at about 150 px/s, at 20, 30, 60 and 120 Hz],
+)
+
+
+=== Test Case 3: Map Walls
+Build the pillars map with `scripts/make-map.py maps/1.txt maps/1.tpmap`, run `./TagPro --server 12345 1` from the project root, and join with two clients.
+
+*Expected Results*:
+- The server logs `Loaded maps/1.tpmap` once, even with several lobbies on the map
+- The game screen draws the walls, and the flags and spawns sit where the text map puts them
+- Players slide along walls and bounce off them, including at corners
+- A missing or corrupt map file logs a warning and the lobby plays the classic arena
 
 #pagebreak()
 
 == Network Protocol Tests
 
-=== Test Case 2: Message Framing
+=== Test Case 4: Message Framing
 Monitor receive buffer parsing
 
 *Expected Results*:
@@ -80,9 +108,95 @@ Monitor receive buffer parsing
 [Client] Disconnected cleanly.
 ```
 
+=== Test Case 5: Input Redundancy on a Lossy Link
+Every `PLAYER_INPUT` repeats the client's last four inputs with their sequence numbers, so the server can recover inputs whose packet was dropped. Setting `TAGPRO_SIM_INPUT_LOSS` to a fraction between 0 and 1 makes the client drop that share of its input packets before sending them.
+
+Run the host with `TAGPRO_SIM_INPUT_LOSS=0.3 ./TagPro`, start a game, and tap the arrow keys quickly to change direction. Open the performance overlay (F3) to watch the input latency.
+
+*Expected Results*:
+- Every direction change is applied even though about 30% of the input packets never reach the server
+- The server's message rate log shows roughly 30% fewer input messages than inputs sent
+- `lastInputSeq` in the snapshots never skips back and keeps increasing by one per input
+
+=== Test Case 6: Concurrent Lobbies
+A dedicated server holds many lobbies. Each lobby has its own game, roster and host. New connections are placed in the first lobby that has not started and has fewer than eight players. A client can leave for a new lobby with `CREATE_LOBBY` or join one by id with `JOIN_LOBBY`. Every move is answered with `PLAYER_JOINED`, `LOBBY_JOINED` and, for the first player in a lobby, `MARK_CLIENT_HOST`.
+
+Start `./TagPro --server`. Connect two clients, then have one of them send `CREATE_LOBBY`. Start the game from each lobby's host.
+
+*Expected Results*:
+- The lobby screens show "Lobby 1" and "Lobby 2", and each player list only contains that lobby's players
+- `REQUEST_START_GAME` from a player who is not the host is ignored
+- Game state snapshots only reach the players of the lobby that is playing
+- When the host leaves, the next player in the lobby becomes host
+- A lobby that has been empty for 30 seconds is torn down (`Tore down idle lobby` in the server log)
+
+=== Test Case 7: Lobby Ids That Look Like Type Bytes
+Lobby ids are sent as text after the type byte, and several type bytes (0x09 to 0x0d) are whitespace. Start `./TagPro --server`, connect a client and have a script send `CREATE_LOBBY` until the server answers with lobby 255, then move the GUI client there with `JOIN_LOBBY` 255. Stop the server afterwards.
+
+*Expected Results*:
+- The client shows "Lobby 255" and stays connected; `LOBBY_JOINED` 255 is not taken for `SERVER_SHUTDOWN` (0xff)
+- Stopping the server sends the one-byte `SERVER_SHUTDOWN`, and every client disconnects on it (`[Client] Disconnected cleanly.`)
+
+=== Test Case 8: Tick Profiler
+Start `./TagPro --server` and connect two clients to the same lobby. Start a game and play for half a minute. Send `kill -USR1 <pid>` to the server, wait 20 seconds, then send it again.
+
+*Expected Results*:
+- The first signal logs `Profiling enabled` and leaves the server running
+- Every 10 seconds after that the server logs one line per tick phase with its calls, mean, p50 and p99
+- The second signal logs `Wrote profiler trace to tagpro-trace-<time>.json`
+- The trace opens in chrome://tracing, with each worker thread's ticks nesting update, physics, collisions and broadcast
+- A server started with `--profile` logs phase timings from the start and writes `tagpro-trace.json` on Ctrl+C
+
 == GUI Integration
 
-=== Test Case 3: Screen Transitions
+=== Test Case 9: Metrics Endpoint
+Start `./TagPro --server 12345 --metrics-port 9100`, connect two clients and start a game. Fetch `curl http://127.0.0.1:9100/metrics` and `curl http://127.0.0.1:9100/status` a few times while playing.
+
+*Expected Results*:
+- `/metrics` is valid Prometheus text: `tagpro_connected_clients 2`, `tagpro_lobbies 1` and a growing `tagpro_tick_duration_seconds_count`
+- `tagpro_messages_received_total{type="player_input"}` grows while a player moves, and `tagpro_messages_sent_total{type="game_state"}` grows by two per tick
+- `/status` parses as JSON and lists the lobby and both clients with their send queue and byte counts
+- Any other path answers 404, a POST answers 405, and the port is not reachable from another machine
+- Scraping in a tight loop (`while curl -s ...; do :; done`) leaves the tick duration histogram unchanged
+
+=== Test Case 10: Load With Headless Clients
+Start `./TagPro --server 12345 --metrics-port 9100`, then run `tagpro_loadgen 500 60 127.0.0.1 12345 mix 4` on the same machine. The load generator fills lobbies of eight, has each lobby's host start the game and prints one line of stats a second.
+
+*Expected Results*:
+- All 500 clients connect and `clients` stays at 500 with 0 disconnects
+- `snaps/s` is close to 500 × 60 = 30000 and the snapshot gap p50 stays near 16.7 ms
+- The gap p99 stays under 33 ms (no snapshot arrives two ticks late)
+- The server's `tagpro_tick_overruns_total` grows by less than 1% of `tagpro_tick_duration_seconds_count`
+- Stopping the server mid-run shows every client as disconnected without the load generator crashing
+
+=== Test Case 11: Input-to-Snapshot Latency
+Run `tagpro_latency_bench 10 30,60,128 1 8 32`. It starts a server and the clients in one process on loopback ports 23800 and up, and runs each tick rate with each client count.
+
+*Expected Results*:
+- Nine JSON lines on stdout, one per run, each with `lost` at 0
+- At 60 Hz, `p50Us` stays under two ticks (33333) for every client count
+- `p50Us` and `p99Us` are higher at 30 Hz than at 60 Hz; above 60 Hz they level off, since the input buffer's delay is counted in 60 Hz client ticks
+- Running the same command twice gives percentiles within a few milliseconds of each other
+
+=== Test Case 12: Memory Accounting and Caps
+Start `tagpro_server 12345 --metrics-port 9100 --max-connection-kb 16`. Connect a client that starts its game and then stops reading (for example a Python socket with a small `SO_RCVBUF` that never calls `recv`), and run `tagpro_loadgen 16 30` next to it. Separately, send `abc:hello` and `99999999:` on raw connections.
+
+*Expected Results*:
+- `curl http://127.0.0.1:9100/status` has a `memory` object with live and peak bytes for game_state, client_buffers, snapshots and logging, and a `memory` entry on every lobby and client
+- The non-reading client is disconnected once its buffers pass 16 KiB, the server logs the cap, and `tagpro_memory_cap_disconnects_total` becomes 1; the load generator reports 0 disconnects
+- Both raw connections are closed at once and the server logs a malformed frame for each
+- Without `--memory-accounting` or `--max-connection-kb`, `/status` has no `memory` fields and nobody is disconnected for slow reading
+
+=== Test Case 13: Flood Protection
+Start `tagpro_server 12345 --metrics-port 9100` and connect two clients to the same lobby. From a raw connection in that lobby, send 20 `REQUEST_PLAYER_LIST` frames (`1:\x04`) at once; start the game and send 6 more at once; then open a third raw connection and send 2000 of them. Finally run `tagpro_loadgen 16 30` against the server.
+
+*Expected Results*:
+- Before the game starts, the other members receive 8 player lists for the 20 requests, and `/status` shows 12 under `messages.rateLimited.request_player_list` and on the sender's `rateLimited`
+- With the game running, the 6 requests produce a single player list and `tagpro_player_list_coalesced_total` grows by 5
+- The 2000-request connection is closed within a second, the server logs that it keeps exceeding its message limits, and `tagpro_flood_disconnects_total` becomes 1
+- The load generator reports 0 disconnects and no loadgen client has a non-zero `rateLimited`
+
+=== Test Case 14: Screen Transitions
 
 Tests we considered:
 - Returning all clients to home screen if the hosts leaves/closes the lobby
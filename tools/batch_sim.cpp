@@ -0,0 +1,224 @@
+// Batch simulation: many full matches back to back, as fast as the CPU
+// allows, for tuning rule constants and comparing bot behaviour. Each
+// match is a RulesGame<RuntimeRules> with scripted Bots that send their
+// inputs through Game::queuePlayerInput like the server does; there are
+// no sockets, no sleeps and no log output (this target is built with every
+// LOG call compiled out). Matches are spread over worker threads; a match
+// depends only on its seed, so results do not depend on the thread count.
+//
+// usage: tagpro_batch [--matches 1000] [--players 8] [--minutes 3] [--score-limit 3]
+//                     [--mode 0] [--map 0] [--threads 0] [--seed 1] [--out FILE]
+//                     [--set NAME=VALUE ...]
+//   --set overrides a rule of the mode, e.g. --set playerAcceleration=70
+// One JSON line per match goes to stdout (or --out), in match order; the
+// totals, including simulated ticks per second, go to stderr.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game/bot.h"
+#include "game/game.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t stepMs = 16; // the server's step at 60 Hz
+constexpr uint32_t ticksPerMinute = 60 * 60;
+
+struct BatchConfig {
+    int matches = 1000;
+    int players = 8;
+    uint32_t maxTicks = 3 * ticksPerMinute;
+    int scoreLimit = 3; // 0: play every match to the time limit
+    GameMode mode = MODE_CLASSIC;
+    uint8_t mapId = 0;
+    int threads = 0;
+    uint32_t seed = 1;
+    RuntimeRules rules = RuntimeRules::of<ClassicRules>();
+    std::string outPath;
+};
+
+struct MatchResult {
+    uint32_t seed = 0;
+    uint32_t ticks = 0;
+    int redScore = 0, blueScore = 0;
+    uint32_t flagGrabs = 0, captures = 0, pops = 0;
+    uint32_t firstCaptureTick = 0; // 0 if nobody scored
+    double meanSpeed = 0;          // px/s over every player and tick
+    double wallMs = 0; // only in the stderr totals, so the JSON lines diff clean across runs
+};
+
+RuntimeRules rulesOf(GameMode mode) {
+    switch (mode) {
+    case MODE_NO_FRICTION: return RuntimeRules::of<NoFrictionRules>();
+    case MODE_SINGLE_FLAG: return RuntimeRules::of<SingleFlagRules>();
+    default: return RuntimeRules::of<ClassicRules>();
+    }
+}
+
+bool setRule(RuntimeRules& rules, const std::string& assignment) {
+    size_t equals = assignment.find('=');
+    if (equals == std::string::npos) return false;
+    std::string name = assignment.substr(0, equals);
+    double value = std::atof(assignment.c_str() + equals + 1);
+    if (name == "playerAcceleration") rules.playerAcceleration = static_cast<float>(value);
+    else if (name == "playerMaxSpeed") rules.playerMaxSpeed = static_cast<float>(value);
+    else if (name == "playerFriction") rules.playerFriction = static_cast<float>(value);
+    else if (name == "playerRestitution") rules.playerRestitution = static_cast<float>(value);
+    else if (name == "wallRestitution") rules.wallRestitution = static_cast<float>(value);
+    else if (name == "respawnDelayMs") rules.respawnDelayMs = static_cast<uint32_t>(value);
+    else return false;
+    return true;
+}
+
+MatchResult runMatch(const BatchConfig& config, uint32_t seed) {
+    auto begin = Clock::now();
+    RulesGame<RuntimeRules> game(1, config.mapId, config.mode, config.rules);
+    std::vector<Bot> bots;
+    for (int p = 0; p < config.players; ++p) {
+        uint32_t id = game.addPlayer("Bot" + std::to_string(p + 1), p % 2);
+        bots.emplace_back(id, seed * 1000 + p);
+    }
+    game.start();
+
+    MatchResult result;
+    result.seed = seed;
+    double speedSum = 0;
+    uint64_t speedSamples = 0;
+    GameState state = game.getGameState();
+    while (result.ticks < config.maxTicks) {
+        for (Bot& bot : bots) {
+            float inputX, inputY;
+            bot.think(state, inputX, inputY);
+            game.queuePlayerInput(bot.getPlayerId(), inputX, inputY);
+        }
+        game.update(stepMs);
+        ++result.ticks;
+
+        for (const GameEvent& event : game.getTickEvents()) {
+            if (event.kind == EVENT_FLAG_TAKEN) ++result.flagGrabs;
+            else if (event.kind == EVENT_POP) ++result.pops;
+            else if (event.kind == EVENT_CAPTURE && ++result.captures == 1) result.firstCaptureTick = result.ticks;
+        }
+        state = game.getGameState();
+        for (const auto& [id, player] : state.players) {
+            speedSum += std::sqrt(player.velocityX * player.velocityX + player.velocityY * player.velocityY);
+        }
+        speedSamples += state.players.size();
+        if (config.scoreLimit > 0 && std::max(state.redScore, state.blueScore) >= config.scoreLimit) break;
+    }
+    result.redScore = state.redScore;
+    result.blueScore = state.blueScore;
+    result.meanSpeed = speedSamples ? speedSum / speedSamples : 0;
+    result.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    return result;
+}
+
+const char* winnerOf(const MatchResult& result) {
+    if (result.redScore > result.blueScore) return "red";
+    if (result.blueScore > result.redScore) return "blue";
+    return "draw";
+}
+
+int usage() {
+    fprintf(stderr,
+            "usage: tagpro_batch [--matches 1000] [--players 8] [--minutes 3] [--score-limit 3]\n"
+            "                    [--mode 0] [--map 0] [--threads 0] [--seed 1] [--out FILE]\n"
+            "                    [--set NAME=VALUE ...]\n"
+            "rules: playerAcceleration playerMaxSpeed playerFriction playerRestitution\n"
+            "       wallRestitution respawnDelayMs\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BatchConfig config;
+    std::vector<std::string> overrides;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) return usage();
+        const char* option = argv[i];
+        const char* value = argv[++i];
+        if (strcmp(option, "--matches") == 0) config.matches = std::max(1, std::atoi(value));
+        else if (strcmp(option, "--players") == 0) config.players = std::max(1, std::atoi(value));
+        else if (strcmp(option, "--minutes") == 0) config.maxTicks = static_cast<uint32_t>(std::atof(value) * ticksPerMinute);
+        else if (strcmp(option, "--score-limit") == 0) config.scoreLimit = std::atoi(value);
+        else if (strcmp(option, "--mode") == 0) config.mode = static_cast<GameMode>(std::atoi(value));
+        else if (strcmp(option, "--map") == 0) config.mapId = static_cast<uint8_t>(std::atoi(value));
+        else if (strcmp(option, "--threads") == 0) config.threads = std::atoi(value);
+        else if (strcmp(option, "--seed") == 0) config.seed = static_cast<uint32_t>(std::atoll(value));
+        else if (strcmp(option, "--out") == 0) config.outPath = value;
+        else if (strcmp(option, "--set") == 0) overrides.push_back(value);
+        else return usage();
+    }
+    // overrides apply on top of the mode's rules, whatever the argument order
+    config.rules = rulesOf(config.mode);
+    for (const std::string& assignment : overrides) {
+        if (!setRule(config.rules, assignment)) {
+            fprintf(stderr, "unknown rule assignment: %s\n", assignment.c_str());
+            return usage();
+        }
+    }
+    int threads = config.threads > 0 ? config.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, config.matches));
+
+    std::vector<MatchResult> results(config.matches);
+    std::atomic<int> nextMatch{0};
+    auto begin = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int match = nextMatch++; match < config.matches; match = nextMatch++) {
+                results[match] = runMatch(config, config.seed + match);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    double wallSec = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    FILE* out = stdout;
+    if (!config.outPath.empty() && !(out = fopen(config.outPath.c_str(), "w"))) {
+        fprintf(stderr, "cannot write %s\n", config.outPath.c_str());
+        return 2;
+    }
+    uint64_t totalTicks = 0, totalCaptures = 0, totalPops = 0;
+    double totalMatchMs = 0, slowestMatchMs = 0;
+    int redWins = 0, blueWins = 0;
+    for (size_t match = 0; match < results.size(); ++match) {
+        const MatchResult& r = results[match];
+        fprintf(out,
+                "{\"match\":%zu,\"seed\":%u,\"ticks\":%u,\"redScore\":%d,\"blueScore\":%d,\"winner\":\"%s\","
+                "\"flagGrabs\":%u,\"captures\":%u,\"pops\":%u,\"firstCaptureTick\":%u,\"meanSpeed\":%.1f}\n",
+                match, r.seed, r.ticks, r.redScore, r.blueScore, winnerOf(r), r.flagGrabs, r.captures, r.pops,
+                r.firstCaptureTick, r.meanSpeed);
+        totalTicks += r.ticks;
+        totalCaptures += r.captures;
+        totalPops += r.pops;
+        totalMatchMs += r.wallMs;
+        slowestMatchMs = std::max(slowestMatchMs, r.wallMs);
+        redWins += r.redScore > r.blueScore;
+        blueWins += r.blueScore > r.redScore;
+    }
+    if (out != stdout) fclose(out);
+
+    double ticksPerSec = totalTicks / wallSec;
+    fprintf(stderr, "%d matches of %d players on %d thread%s in %.2f s\n", config.matches, config.players, threads,
+            threads == 1 ? "" : "s", wallSec);
+    fprintf(stderr, "%llu simulated ticks, %.0f ticks/s (%.0fx real time)\n", (unsigned long long)totalTicks,
+            ticksPerSec, ticksPerSec * stepMs / 1000.0);
+    fprintf(stderr, "red %d, blue %d, draw %d; per match: %.2f captures, %.2f pops, %.0f ticks\n", redWins,
+            blueWins, config.matches - redWins - blueWins, double(totalCaptures) / config.matches,
+            double(totalPops) / config.matches, double(totalTicks) / config.matches);
+    fprintf(stderr, "match wall time: mean %.2f ms, slowest %.2f ms\n", totalMatchMs / config.matches,
+            slowestMatchMs);
+    return 0;
+}
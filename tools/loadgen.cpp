@@ -0,0 +1,456 @@
+// Load generator: N headless players against a running `TagPro --server`.
+// Each connection speaks the game protocol through the Protocol helpers
+// over a non-blocking socket; a few worker threads poll() their share of
+// the connections, decode every snapshot and drive inputs the way the GUI
+// does: sent when they change, plus a 250 ms heartbeat. Lobby hosts start
+// their games once every client is connected.
+//
+// Behaviours: chase (Bot: run for the enemy flag and carry it home),
+// walk (random 8-way walk), idle (heartbeats only), mix (round robin).
+//
+// usage: tagpro_loadgen [clients] [seconds] [host] [port] [behaviour] [threads]
+// One line of stats a second goes to stdout, then a summary.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game/bot.h"
+#include "network/network.h"
+#include "network/protocol.h"
+
+#ifdef _WIN32
+    #define poll WSAPoll
+#else
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <cerrno>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto frameInterval = std::chrono::microseconds(1000000 / 60);
+constexpr auto inputHeartbeat = std::chrono::milliseconds(250);
+constexpr uint32_t expectedSnapshotGapUs = 1000000 / 60;
+
+enum Behaviour { BEHAVIOUR_CHASE, BEHAVIOUR_WALK, BEHAVIOUR_IDLE };
+
+bool setNonBlocking(SOCKET socket) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(socket, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL; // a closed server must not kill us with SIGPIPE
+#else
+constexpr int sendFlags = 0;
+#endif
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+}
+
+struct LoadClient {
+    SOCKET socket = INVALID_SOCKET;
+    Behaviour behaviour = BEHAVIOUR_IDLE;
+    Clock::time_point connected;
+    uint32_t playerId = 0;
+    bool host = false;
+    bool startSent = false;
+
+    std::string inbox, outbox; // outbox: framed bytes the socket did not take yet
+
+    GameState state;
+    std::unique_ptr<Bot> bot;
+    std::mt19937 rng;
+    int walkX = 0, walkY = 0;
+    int framesUntilTurn = 0;
+
+    float sentX = 0, sentY = 0;
+    Clock::time_point lastInput;
+    uint32_t inputSequence = 0;
+    std::deque<Protocol::InputSample> inputHistory; // newest first
+
+    Clock::time_point lastSnapshot;
+    bool seenSnapshot = false;
+};
+
+// shared between a worker and the reporting thread
+struct WorkerStats {
+    std::atomic<uint64_t> snapshots{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<uint32_t> open{0};
+
+    std::mutex gapsMutex;
+    std::vector<uint32_t> gapsUs; // snapshot inter-arrival times since the last report
+};
+
+class Worker {
+public:
+    Worker(std::atomic<bool>& running, std::atomic<bool>& startGames)
+      : running(running), startGames(startGames) {}
+
+    void adopt(std::unique_ptr<LoadClient> client) {
+        std::lock_guard<std::mutex> lock(incomingMutex);
+        incoming.push_back(std::move(client));
+    }
+
+    void run();
+    WorkerStats stats;
+
+private:
+    void receive(LoadClient& client);
+    void handleMessage(LoadClient& client, const std::string& message, Clock::time_point now);
+    void think(LoadClient& client, Clock::time_point now);
+    void queue(LoadClient& client, const std::string& message);
+    void flush(LoadClient& client);
+    void drop(LoadClient& client);
+
+    std::atomic<bool>& running;
+    std::atomic<bool>& startGames;
+
+    std::mutex incomingMutex;
+    std::vector<std::unique_ptr<LoadClient>> incoming; // guarded by incomingMutex
+    std::vector<std::unique_ptr<LoadClient>> clients;
+    std::vector<uint32_t> pendingGaps;
+};
+
+void Worker::run() {
+    std::vector<pollfd> fds;
+    auto nextFrame = Clock::now();
+    while (running) {
+        {
+            std::lock_guard<std::mutex> lock(incomingMutex);
+            for (auto& client : incoming) clients.push_back(std::move(client));
+            incoming.clear();
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const auto& client) { return client->socket == INVALID_SOCKET; }),
+                      clients.end());
+        stats.open = static_cast<uint32_t>(clients.size());
+
+        fds.clear();
+        for (auto& client : clients) {
+            short events = POLLIN;
+            if (!client->outbox.empty()) events |= POLLOUT;
+            fds.push_back({client->socket, events, 0});
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - Clock::now()).count();
+        int timeoutMs = static_cast<int>(std::clamp<long long>(wait, 0, 16));
+        if (fds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        } else if (poll(fds.data(), static_cast<unsigned long>(fds.size()), timeoutMs) > 0) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                LoadClient& client = *clients[i];
+                if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) receive(client);
+                if ((fds[i].revents & POLLOUT) && client.socket != INVALID_SOCKET) flush(client);
+            }
+        }
+
+        auto now = Clock::now();
+        if (now >= nextFrame) {
+            for (auto& client : clients) {
+                if (client->socket != INVALID_SOCKET) think(*client, now);
+            }
+            nextFrame += frameInterval;
+            if (now > nextFrame + frameInterval) nextFrame = now + frameInterval; // fell behind
+        }
+
+        if (!pendingGaps.empty()) {
+            std::lock_guard<std::mutex> lock(stats.gapsMutex);
+            stats.gapsUs.insert(stats.gapsUs.end(), pendingGaps.begin(), pendingGaps.end());
+            pendingGaps.clear();
+        }
+    }
+    for (auto& client : clients) {
+        if (client->socket != INVALID_SOCKET) closeSocket(client->socket);
+    }
+}
+
+void Worker::receive(LoadClient& client) {
+    char buffer[16384];
+    while (client.socket != INVALID_SOCKET) {
+        int bytes = recv(client.socket, buffer, sizeof(buffer), 0);
+        if (bytes < 0 && wouldBlock()) break;
+        if (bytes <= 0) {
+            drop(client);
+            return;
+        }
+        stats.bytesIn += bytes;
+        client.inbox.append(buffer, bytes);
+    }
+
+    auto now = Clock::now();
+    std::string message;
+    while (client.socket != INVALID_SOCKET) {
+        Protocol::FrameStatus status = Protocol::extractMessage(client.inbox, message);
+        if (status == Protocol::FRAME_INCOMPLETE) break;
+        if (status == Protocol::FRAME_MALFORMED) {
+            drop(client); // the inbox would otherwise grow until the run ends
+            break;
+        }
+        handleMessage(client, message, now);
+    }
+}
+
+void Worker::handleMessage(LoadClient& client, const std::string& message, Clock::time_point now) {
+    if (message.empty()) return;
+    uint64_t timestampUs;
+    switch (static_cast<uint8_t>(message[0])) {
+        case Protocol::GAME_STATE:
+            if (!Protocol::deserializeGameState(message, client.state)) break;
+            ++stats.snapshots;
+            if (client.seenSnapshot) {
+                pendingGaps.push_back(static_cast<uint32_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - client.lastSnapshot).count()));
+            }
+            client.lastSnapshot = now;
+            client.seenSnapshot = true;
+            break;
+        case Protocol::PLAYER_JOINED:
+            Protocol::deserializePlayerJoined(message, client.playerId);
+            client.bot = std::make_unique<Bot>(client.playerId, client.rng());
+            break;
+        case Protocol::MARK_CLIENT_HOST:
+            client.host = true;
+            break;
+        case Protocol::PING:
+            // the server tracks its round trip to every client
+            if (Protocol::deserializePing(message, timestampUs)) {
+                uint64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    now.time_since_epoch()).count();
+                queue(client, Protocol::serializePong(timestampUs, nowUs, nowUs));
+            }
+            break;
+        case Protocol::SERVER_SHUTDOWN:
+            drop(client);
+            break;
+        default:
+            break;
+    }
+}
+
+void Worker::think(LoadClient& client, Clock::time_point now) {
+    if (client.host && !client.startSent && startGames) {
+        queue(client, Protocol::serializeRequestStartGame());
+        client.startSent = true;
+    }
+    if (client.playerId == 0) return;
+
+    float inputX = 0, inputY = 0;
+    switch (client.behaviour) {
+        case BEHAVIOUR_CHASE:
+            if (client.bot) client.bot->think(client.state, inputX, inputY);
+            // keyboard players only ever hold one of eight directions
+            inputX = inputX > 0.3f ? 1.0f : (inputX < -0.3f ? -1.0f : 0.0f);
+            inputY = inputY > 0.3f ? 1.0f : (inputY < -0.3f ? -1.0f : 0.0f);
+            break;
+        case BEHAVIOUR_WALK:
+            if (client.framesUntilTurn-- <= 0) {
+                std::uniform_int_distribution<int> direction(-1, 1);
+                std::uniform_int_distribution<int> hold(20, 90);
+                client.walkX = direction(client.rng);
+                client.walkY = direction(client.rng);
+                client.framesUntilTurn = hold(client.rng);
+            }
+            inputX = static_cast<float>(client.walkX);
+            inputY = static_cast<float>(client.walkY);
+            break;
+        case BEHAVIOUR_IDLE:
+            break;
+    }
+
+    bool changed = inputX != client.sentX || inputY != client.sentY;
+    if (!changed && now - client.lastInput < inputHeartbeat) return;
+    client.sentX = inputX;
+    client.sentY = inputY;
+    client.lastInput = now;
+
+    // same redundancy as Client::sendPlayerInput
+    auto clientTick = static_cast<uint32_t>((now - client.connected) / frameInterval);
+    client.inputHistory.push_front({++client.inputSequence, clientTick, inputX, inputY});
+    if (client.inputHistory.size() > Protocol::inputRedundancy) client.inputHistory.pop_back();
+    std::vector<Protocol::InputSample> samples(client.inputHistory.begin(), client.inputHistory.end());
+    queue(client, Protocol::serializePlayerInput(client.playerId, samples));
+}
+
+void Worker::queue(LoadClient& client, const std::string& message) {
+    client.outbox += Protocol::frameMessage(message);
+    flush(client);
+}
+
+void Worker::flush(LoadClient& client) {
+    while (!client.outbox.empty() && client.socket != INVALID_SOCKET) {
+        int bytes = send(client.socket, client.outbox.data(), static_cast<int>(client.outbox.size()), sendFlags);
+        if (bytes < 0 && wouldBlock()) return; // poll() says when there is room
+        if (bytes <= 0) {
+            drop(client);
+            return;
+        }
+        stats.bytesOut += bytes;
+        client.outbox.erase(0, bytes);
+    }
+}
+
+void Worker::drop(LoadClient& client) {
+    if (client.socket == INVALID_SOCKET) return;
+    closeSocket(client.socket);
+    client.socket = INVALID_SOCKET;
+    if (running) ++stats.disconnects;
+}
+
+SOCKET connectTo(const char* host, int port) {
+    SOCKET socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (socket == INVALID_SOCKET) return INVALID_SOCKET;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1 ||
+        connect(socket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        !setNonBlocking(socket)) {
+        closeSocket(socket);
+        return INVALID_SOCKET;
+    }
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (char*)&noDelay, sizeof(noDelay));
+    return socket;
+}
+
+Behaviour parseBehaviour(const char* name, int index) {
+    if (strcmp(name, "chase") == 0) return BEHAVIOUR_CHASE;
+    if (strcmp(name, "walk") == 0) return BEHAVIOUR_WALK;
+    if (strcmp(name, "idle") == 0) return BEHAVIOUR_IDLE;
+    // mix: mostly players who play, a few who stand around
+    const Behaviour mix[] = {BEHAVIOUR_CHASE, BEHAVIOUR_CHASE, BEHAVIOUR_WALK, BEHAVIOUR_IDLE};
+    return mix[index % 4];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int clientCount = argc > 1 ? std::atoi(argv[1]) : 100;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 30;
+    const char* host = argc > 3 ? argv[3] : "127.0.0.1";
+    int port = argc > 4 ? std::atoi(argv[4]) : 12345;
+    const char* behaviour = argc > 5 ? argv[5] : "mix";
+    int threadCount = argc > 6 ? std::atoi(argv[6]) : 4;
+    if (clientCount < 1 || threadCount < 1) {
+        fprintf(stderr, "usage: tagpro_loadgen [clients] [seconds] [host] [port] [chase|walk|idle|mix] [threads]\n");
+        return 1;
+    }
+    if (!initSockets()) {
+        fprintf(stderr, "socket initialization failed\n");
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<bool> startGames{false};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>(running, startGames));
+        threads.emplace_back(&Worker::run, workers.back().get());
+    }
+
+    // ramp up at about 500 connections a second so the accept loop keeps up
+    printf("connecting %d clients (%s) to %s:%d with %d threads\n", clientCount, behaviour, host, port, threadCount);
+    fflush(stdout);
+    int failed = 0;
+    for (int i = 0; i < clientCount; ++i) {
+        SOCKET socket = connectTo(host, port);
+        if (socket == INVALID_SOCKET) {
+            ++failed;
+            continue;
+        }
+        auto client = std::make_unique<LoadClient>();
+        client->socket = socket;
+        client->behaviour = parseBehaviour(behaviour, i);
+        client->connected = Clock::now();
+        client->rng.seed(i + 1);
+        workers[i % threadCount]->adopt(std::move(client));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    if (failed) printf("%d of %d connections failed\n", failed, clientCount);
+    // lobbies only take players until their game starts
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    startGames = true;
+
+    printf("%5s %7s %9s %9s %9s %8s %8s %8s %11s\n",
+           "sec", "clients", "snaps/s", "KiB/s in", "KiB/s out", "gap p50", "gap p99", "gap max", "disconnects");
+    std::vector<uint32_t> allGaps;
+    uint64_t lastSnapshots = 0, lastIn = 0, lastOut = 0;
+    auto begin = Clock::now();
+    for (int second = 1; second <= seconds; ++second) {
+        std::this_thread::sleep_until(begin + std::chrono::seconds(second));
+        uint64_t snapshots = 0, in = 0, out = 0, disconnects = 0;
+        uint32_t open = 0;
+        std::vector<uint32_t> gaps;
+        for (auto& worker : workers) {
+            WorkerStats& stats = worker->stats;
+            snapshots += stats.snapshots;
+            in += stats.bytesIn;
+            out += stats.bytesOut;
+            disconnects += stats.disconnects;
+            open += stats.open;
+            std::lock_guard<std::mutex> lock(stats.gapsMutex);
+            gaps.insert(gaps.end(), stats.gapsUs.begin(), stats.gapsUs.end());
+            stats.gapsUs.clear();
+        }
+        std::sort(gaps.begin(), gaps.end());
+        printf("%5d %7u %9llu %9.1f %9.1f %6.1fms %6.1fms %6.1fms %11llu\n", second, open,
+               (unsigned long long)(snapshots - lastSnapshots), (in - lastIn) / 1024.0, (out - lastOut) / 1024.0,
+               percentile(gaps, 0.50) / 1000.0, percentile(gaps, 0.99) / 1000.0,
+               gaps.empty() ? 0.0 : gaps.back() / 1000.0, (unsigned long long)disconnects);
+        fflush(stdout);
+        lastSnapshots = snapshots;
+        lastIn = in;
+        lastOut = out;
+        allGaps.insert(allGaps.end(), gaps.begin(), gaps.end());
+    }
+
+    running = false;
+    for (auto& thread : threads) thread.join();
+
+    std::sort(allGaps.begin(), allGaps.end());
+    double deviation = 0;
+    for (uint32_t gap : allGaps) deviation += std::abs(static_cast<double>(gap) - expectedSnapshotGapUs);
+    uint64_t disconnects = 0;
+    for (auto& worker : workers) disconnects += worker->stats.disconnects;
+    printf("snapshot gaps: %zu, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+           allGaps.size(), percentile(allGaps, 0.50) / 1000.0, percentile(allGaps, 0.90) / 1000.0,
+           percentile(allGaps, 0.99) / 1000.0, percentile(allGaps, 0.999) / 1000.0,
+           allGaps.empty() ? 0.0 : allGaps.back() / 1000.0);
+    printf("jitter (mean distance from %.2f ms): %.2f ms; disconnects: %llu; failed connects: %d\n",
+           expectedSnapshotGapUs / 1000.0, allGaps.empty() ? 0.0 : deviation / allGaps.size() / 1000.0,
+           (unsigned long long)disconnects, failed);
+    cleanupSockets();
+    return 0;
+}